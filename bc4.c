@@ -0,0 +1,254 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012,2013 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ----------------------------------------------------------------------------
+ */
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BC4_SSE2
+#endif
+#include "bc4.h"
+
+
+/* Codes of a block's palette ordered by increasing value, for r0 > r1 (six
+ * values interpolated from r1 up to r0) and r0 <= r1 (four values
+ * interpolated from r0 up to r1, plus 0 and 255) */
+static const unsigned char bc4_order[2][8] = { { 1, 7, 6, 5, 4, 3, 2, 0 },
+                                               { 6, 0, 2, 3, 4, 5, 1, 7 } };
+
+
+// ------------------------------------------------------------ bc4_palette ---
+static void
+bc4_palette( unsigned char r0, unsigned char r1, unsigned char * palette )
+{
+    int i;
+
+    palette[0] = r0;
+    palette[1] = r1;
+    if( r0 > r1 )
+    {
+        for( i = 0; i < 6; ++i )
+            palette[2+i] = ((6-i)*r0 + (1+i)*r1 + 3) / 7;
+    }
+    else
+    {
+        for( i = 0; i < 4; ++i )
+            palette[2+i] = ((4-i)*r0 + (1+i)*r1 + 2) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+
+// ----------------------------------------------------------- bc4_quantize ---
+/* Finds the nearest of the sorted palette values for each of 16 texels,
+ * storing its rank, and returns the sum of squared errors. A texel is past
+ * rank k when it reaches the midpoint between values k and k+1. */
+#if defined(BC4_SSE2)
+static unsigned int
+bc4_quantize( const unsigned char * texels,
+              const unsigned char * values,
+              unsigned char * ranks )
+{
+    __m128i v = _mm_loadu_si128( (const __m128i *) texels );
+    __m128i rank = _mm_setzero_si128( );
+    __m128i nearest = _mm_set1_epi8( (char) values[0] );
+    __m128i mask, diff, lo, hi, sum;
+    int k;
+
+    for( k = 0; k < 7; ++k )
+    {
+        mask = _mm_set1_epi8( (char) ((values[k] + values[k+1] + 1) >> 1) );
+        mask = _mm_cmpeq_epi8( _mm_max_epu8( v, mask ), v );
+        rank = _mm_sub_epi8( rank, mask );
+        nearest = _mm_or_si128( _mm_and_si128( mask, _mm_set1_epi8( (char) values[k+1] ) ),
+                                _mm_andnot_si128( mask, nearest ) );
+    }
+    _mm_storeu_si128( (__m128i *) ranks, rank );
+
+    diff = _mm_or_si128( _mm_subs_epu8( v, nearest ), _mm_subs_epu8( nearest, v ) );
+    lo = _mm_unpacklo_epi8( diff, _mm_setzero_si128( ) );
+    hi = _mm_unpackhi_epi8( diff, _mm_setzero_si128( ) );
+    sum = _mm_add_epi32( _mm_madd_epi16( lo, lo ), _mm_madd_epi16( hi, hi ) );
+    sum = _mm_add_epi32( sum, _mm_shuffle_epi32( sum, _MM_SHUFFLE(1,0,3,2) ) );
+    sum = _mm_add_epi32( sum, _mm_shuffle_epi32( sum, _MM_SHUFFLE(2,3,0,1) ) );
+    return (unsigned int) _mm_cvtsi128_si32( sum );
+}
+#else
+static unsigned int
+bc4_quantize( const unsigned char * texels,
+              const unsigned char * values,
+              unsigned char * ranks )
+{
+    unsigned int error = 0;
+    int i, k, d;
+
+    for( i = 0; i < 16; ++i )
+    {
+        ranks[i] = 0;
+        for( k = 0; k < 7; ++k )
+        {
+            if( texels[i] >= ((values[k] + values[k+1] + 1) >> 1) )
+                ranks[i] = k + 1;
+        }
+        d = texels[i] - values[ranks[i]];
+        error += d * d;
+    }
+    return error;
+}
+#endif
+
+
+// ------------------------------------------------------- bc4_encode_block ---
+/* Tries both palette modes, the first spanning the whole range of the
+ * block, the second the range of the texels other than 0 and 255, which
+ * are then exact, and keeps the closest. */
+static void
+bc4_encode_block( const unsigned char * texels, unsigned char * block )
+{
+    unsigned char palette[8], values[8], ranks[16];
+    unsigned char lo = 255, hi = 0, inner_lo = 255, inner_hi = 0;
+    unsigned char endpoints[2][2];
+    unsigned int error, best_error = (unsigned int) -1;
+    int i, mode, best = 1;
+    unsigned long long bits = 0;
+
+    for( i = 0; i < 16; ++i )
+    {
+        if( texels[i] < lo ) lo = texels[i];
+        if( texels[i] > hi ) hi = texels[i];
+        if( texels[i] != 0 && texels[i] != 255 )
+        {
+            if( texels[i] < inner_lo ) inner_lo = texels[i];
+            if( texels[i] > inner_hi ) inner_hi = texels[i];
+        }
+    }
+    if( inner_lo > inner_hi )
+        inner_lo = inner_hi = 0;
+    endpoints[0][0] = hi;
+    endpoints[0][1] = lo;
+    endpoints[1][0] = inner_lo;
+    endpoints[1][1] = inner_hi;
+
+    for( mode = hi > lo ? 0 : 1; mode < 2; ++mode )
+    {
+        bc4_palette( endpoints[mode][0], endpoints[mode][1], palette );
+        for( i = 0; i < 8; ++i )
+            values[i] = palette[bc4_order[mode][i]];
+        error = bc4_quantize( texels, values, ranks );
+        if( error < best_error )
+        {
+            best_error = error;
+            best = mode;
+            for( i = 15, bits = 0; i >= 0; --i )
+                bits = (bits << 3) | bc4_order[mode][ranks[i]];
+        }
+    }
+
+    block[0] = endpoints[best][0];
+    block[1] = endpoints[best][1];
+    for( i = 0; i < 6; ++i )
+        block[2+i] = (unsigned char) (bits >> (8*i));
+}
+
+
+// --------------------------------------------------------------- bc4_size ---
+size_t
+bc4_size( size_t width, size_t height )
+{
+    return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+
+// ------------------------------------------------------------- bc4_encode ---
+void
+bc4_encode( const unsigned char * image,
+            size_t width,
+            size_t height,
+            unsigned char * blocks )
+{
+    unsigned char texels[16];
+    size_t x, y, i, j, u, v;
+
+    for( y = 0; y < height; y += 4 )
+    {
+        for( x = 0; x < width; x += 4, blocks += 8 )
+        {
+            for( j = 0; j < 4; ++j )
+            {
+                v = y + j < height ? y + j : height - 1;
+                if( x + 4 <= width )
+                {
+                    memcpy( texels + 4*j, image + v*width + x, 4 );
+                    continue;
+                }
+                for( i = 0; i < 4; ++i )
+                {
+                    u = x + i < width ? x + i : width - 1;
+                    texels[4*j+i] = image[v*width + u];
+                }
+            }
+            bc4_encode_block( texels, blocks );
+        }
+    }
+}
+
+
+// ------------------------------------------------------------- bc4_decode ---
+void
+bc4_decode( const unsigned char * blocks,
+            size_t width,
+            size_t height,
+            unsigned char * image )
+{
+    unsigned char palette[8];
+    unsigned long long bits;
+    size_t x, y, i, j;
+
+    for( y = 0; y < height; y += 4 )
+    {
+        for( x = 0; x < width; x += 4, blocks += 8 )
+        {
+            bc4_palette( blocks[0], blocks[1], palette );
+            for( i = 0, bits = 0; i < 6; ++i )
+                bits |= (unsigned long long) blocks[2+i] << (8*i);
+            for( j = 0; j < 4; ++j )
+            {
+                for( i = 0; i < 4; ++i, bits >>= 3 )
+                {
+                    if( x + i < width && y + j < height )
+                        image[(y+j)*width + x+i] = palette[bits & 7];
+                }
+            }
+        }
+    }
+}
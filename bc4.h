@@ -0,0 +1,135 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012,2013 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ----------------------------------------------------------------------------
+ */
+#ifndef __BC4_H__
+#define __BC4_H__
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+namespace ftgl {
+#endif
+
+/**
+ * @file   bc4.h
+ *
+ * @defgroup bc4 BC4 compression
+ *
+ * Functions to compress single channel images, such as atlases of depth 1,
+ * into BC4 (also known as RGTC1) blocks, which a GPU samples directly at half
+ * the memory and bandwidth of the original. Each 4x4 block of texels is
+ * stored in 8 bytes: two endpoints and a 3 bit index per texel into a palette
+ * interpolated between them.
+ *
+ * The encoder is meant for static atlases (makefont output, signed distance
+ * fields computed ahead of time) and processes a block with SSE2 when the
+ * compiler targets it.
+ *
+ * <b>Example Usage</b>:
+ * @code
+ * #include "bc4.h"
+ *
+ * int main( int arrgc, char *argv[] )
+ * {
+ *     texture_atlas_t * atlas = texture_atlas_new( 512, 512, 1 );
+ *     unsigned char * blocks;
+ *
+ *     // ... load fonts into the atlas ...
+ *
+ *     blocks = (unsigned char *) malloc( bc4_size( atlas->width, atlas->height ) );
+ *     bc4_encode( atlas->data, atlas->width, atlas->height, blocks );
+ *     glCompressedTexImage2D( GL_TEXTURE_2D, 0, GL_COMPRESSED_RED_RGTC1,
+ *                             atlas->width, atlas->height, 0,
+ *                             bc4_size( atlas->width, atlas->height ), blocks );
+ *
+ *     return 0;
+ * }
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * Size of a BC4 compressed image.
+ *
+ * @param width   width of the image
+ * @param height  height of the image
+ *
+ * @return        number of bytes of the compressed image, 8 per block of 4x4
+ *                texels, partial blocks included
+ */
+  size_t
+  bc4_size( size_t width, size_t height );
+
+
+/**
+ * Compress a single channel image into BC4 blocks, stored left to right and
+ * top to bottom. Partial blocks on the right and bottom edges repeat the
+ * last column and row of the image.
+ *
+ * @param image   a width x height greyscale image
+ * @param width   width of the image
+ * @param height  height of the image
+ * @param blocks  destination of bc4_size(width, height) bytes
+ */
+  void
+  bc4_encode( const unsigned char * image,
+              size_t width,
+              size_t height,
+              unsigned char * blocks );
+
+
+/**
+ * Decompress BC4 blocks into a single channel image, as a GPU would sample
+ * them.
+ *
+ * @param blocks  bc4_size(width, height) bytes of compressed blocks
+ * @param width   width of the image
+ * @param height  height of the image
+ * @param image   destination of width x height bytes
+ */
+  void
+  bc4_decode( const unsigned char * blocks,
+              size_t width,
+              size_t height,
+              unsigned char * image );
+
+/** @} */
+
+#ifdef __cplusplus
+}
+}
+#endif
+
+#endif /* __BC4_H__ */
@@ -0,0 +1,104 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "texture-atlas.h"
+
+
+// ------------------------------------------------------- global variables ---
+const size_t sizes[] = { 512, 1024, 2048, 4096 };
+
+
+// ------------------------------------------------------------------- next ---
+/* Small deterministic generator so every run packs the same regions */
+unsigned int next( unsigned int *seed )
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7fff;
+}
+
+
+// ------------------------------------------------------------------- pack ---
+void pack( const size_t size )
+{
+    texture_atlas_t *atlas = texture_atlas_new( size, size, 1 );
+    unsigned int seed = 1, checksum = 0;
+    size_t count = 0, missed = 0;
+    clock_t start = clock( );
+    double elapsed;
+
+    // Glyph sized regions (4 to 35 pixels) until 100 requests in a row fail
+    while( missed < 100 )
+    {
+        size_t width = 4 + next( &seed ) % 32;
+        size_t height = 4 + next( &seed ) % 32;
+        ivec4 region = texture_atlas_get_region( atlas, width, height );
+
+        if( region.x < 0 )
+        {
+            ++missed;
+            continue;
+        }
+        missed = 0;
+        ++count;
+        checksum = checksum * 31 + region.x * 4099 + region.y;
+    }
+    elapsed = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+    printf( "%5zu² %10zu %10.1f %11.1f%% %12.1f   %08x\n",
+            size, count, 1000.0 * elapsed,
+            100.0 * atlas->used / (double)(size * size),
+            count ? 1e6 * elapsed / count : 0.0, checksum );
+
+    texture_atlas_delete( atlas );
+}
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    size_t i;
+
+    printf( "%6s %10s %10s %12s %12s   %8s\n",
+            "atlas", "regions", "pack (ms)", "occupancy", "per region (us)",
+            "checksum" );
+    for( i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i )
+    {
+        pack( sizes[i] );
+    }
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "freetype-gl.h"
+#include "bc4.h"
+
+
+// ------------------------------------------------------- global variables ---
+const char *filename = "fonts/Vera.ttf";
+const size_t atlas_size = 1024;
+const size_t repeats = 20;
+
+
+// ----------------------------------------------------------------- report ---
+void report( const char *name, rendermode_t rendermode, float size )
+{
+    size_t i, n, compressed, max_error = 0;
+    double squared = 0.0, absolute = 0.0, psnr, elapsed;
+    unsigned char *blocks, *decoded;
+    texture_atlas_t *atlas;
+    texture_font_t *font;
+    clock_t start;
+
+    atlas = texture_atlas_new( atlas_size, atlas_size, 1 );
+    font = texture_font_new_from_file( atlas, size, filename );
+    if( !font )
+    {
+        texture_atlas_delete( atlas );
+        return;
+    }
+    font->rendermode = rendermode;
+    for( i = 0x20; i < 0x17F; ++i )
+    {
+        texture_font_get_glyph_utf32( font, i );
+    }
+
+    n = atlas->width * atlas->height;
+    compressed = bc4_size( atlas->width, atlas->height );
+    blocks = malloc( compressed );
+    decoded = malloc( n );
+
+    start = clock( );
+    for( i = 0; i < repeats; ++i )
+    {
+        bc4_encode( atlas->data, atlas->width, atlas->height, blocks );
+    }
+    elapsed = (clock( ) - start) / (double) CLOCKS_PER_SEC / repeats;
+    bc4_decode( blocks, atlas->width, atlas->height, decoded );
+
+    // Errors over the whole atlas, empty space included
+    for( i = 0; i < n; ++i )
+    {
+        size_t error = abs( (int)atlas->data[i] - (int)decoded[i] );
+        if( error > max_error )
+        {
+            max_error = error;
+        }
+        absolute += error;
+        squared += error * error;
+    }
+    psnr = squared > 0.0 ? 10.0 * log10( 255.0 * 255.0 * n / squared ) : INFINITY;
+
+    printf( "%-22s %5.0f %10zu %10zu %8.2f %8.3f %8zu %10.1f %10.1f\n",
+            name, size, n, compressed, psnr, absolute / n, max_error,
+            1000.0 * elapsed, n / elapsed / 1e6 );
+
+    free( decoded );
+    free( blocks );
+    texture_font_delete( font );
+    texture_atlas_delete( atlas );
+}
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    if( argc > 1 )
+    {
+        filename = argv[1];
+    }
+
+    printf( "Font: %s, %zux%zu atlas, Latin-1 and Latin Extended-A\n",
+            filename, atlas_size, atlas_size );
+    printf( "%-22s %5s %10s %10s %8s %8s %8s %10s %10s\n",
+            "glyphs", "size", "bytes", "bc4 bytes", "PSNR", "mean err",
+            "max err", "encode ms", "Mtexel/s" );
+
+    report( "coverage", RENDER_NORMAL, 16 );
+    report( "coverage", RENDER_NORMAL, 32 );
+    report( "signed distance field", RENDER_SIGNED_DISTANCE_FIELD, 32 );
+    report( "signed distance field", RENDER_SIGNED_DISTANCE_FIELD, 64 );
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freetype-gl.h"
+#include "text-buffer.h"
+#include "markup.h"
+
+#include <GLFW/glfw3.h>
+
+
+// ------------------------------------------------------- global variables ---
+const char *filename = "fonts/Vera.ttf";
+const size_t glyph_count = 100000;
+const size_t repeat = 10;
+
+
+// ------------------------------------------------------------------ build ---
+double build( text_buffer_t *buffer, markup_t *markup,
+              const char *text, int reserve )
+{
+    size_t i;
+    clock_t start;
+    vec2 pen;
+
+    start = clock( );
+    for( i = 0; i < repeat; ++i )
+    {
+        text_buffer_clear( buffer );
+        // Release the storage so that every run grows from scratch
+        vector_shrink( buffer->buffer->vertices );
+        vector_shrink( buffer->buffer->indices );
+        vector_shrink( buffer->buffer->items );
+
+        if( reserve )
+        {
+            text_buffer_reserve( buffer, strlen( text ) );
+        }
+        pen.x = 0; pen.y = 0;
+        text_buffer_add_text( buffer, &pen, markup, text, 0 );
+    }
+    return 1000.0 * (clock( ) - start) / (double) CLOCKS_PER_SEC / repeat;
+}
+
+
+// --------------------------------------------------------- error_callback ---
+void error_callback( int error, const char* description )
+{
+    fputs( description, stderr );
+}
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    GLFWwindow* window;
+    text_buffer_t *buffer;
+    markup_t markup;
+    vec4 black = {{0.0, 0.0, 0.0, 1.0}};
+    char *text;
+    size_t i;
+
+    glfwSetErrorCallback( error_callback );
+
+    if (!glfwInit( ))
+    {
+        exit( EXIT_FAILURE );
+    }
+
+    glfwWindowHint( GLFW_VISIBLE, GL_FALSE );
+    window = glfwCreateWindow( 1, 1, argv[0], NULL, NULL );
+
+    if (!window)
+    {
+        glfwTerminate( );
+        exit( EXIT_FAILURE );
+    }
+
+    glfwMakeContextCurrent( window );
+
+#ifndef __APPLE__
+    glewExperimental = GL_TRUE;
+    GLenum err = glewInit();
+    if (GLEW_OK != err)
+    {
+        /* Problem: glewInit failed, something is seriously wrong. */
+        fprintf( stderr, "Error: %s\n", glewGetErrorString(err) );
+        exit( EXIT_FAILURE );
+    }
+#endif
+
+    if( argc > 1 )
+    {
+        filename = argv[1];
+    }
+
+    buffer = text_buffer_new_with_program( LCD_FILTERING_OFF, 0 );
+    memset( &markup, 0, sizeof(markup) );
+    markup.family = (char *) filename;
+    markup.size = 12.0;
+    markup.gamma = 1.0;
+    markup.foreground_color = black;
+    markup.font = font_manager_get_from_filename( buffer->manager,
+                                                  filename, markup.size );
+    if( !markup.font )
+    {
+        fprintf( stderr, "Unable to load font %s\n", filename );
+        exit( EXIT_FAILURE );
+    }
+
+    // Printable ASCII, one line per 100 glyphs
+    text = malloc( glyph_count + 1 );
+    for( i = 0; i < glyph_count; ++i )
+    {
+        text[i] = (i % 100 == 99) ? '\n' : (char)(' ' + i % 95);
+    }
+    text[glyph_count] = 0;
+    texture_font_load_glyphs( markup.font, text );
+
+    printf( "Font: %s, %zu glyphs per build\n", filename, glyph_count );
+    printf( "%-10s %12s\n", "mode", "build (ms)" );
+    printf( "%-10s %12.2f\n", "grow", build( buffer, &markup, text, 0 ) );
+    printf( "%-10s %12.2f\n", "reserve", build( buffer, &markup, text, 1 ) );
+    printf( "Vertices: %zu, indices: %zu\n",
+            vector_size( buffer->buffer->vertices ),
+            vector_size( buffer->buffer->indices ) );
+
+    free( text );
+    text_buffer_delete( buffer );
+    glfwDestroyWindow( window );
+    glfwTerminate( );
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freetype-gl.h"
+#include "utf8-utils.h"
+
+
+// ------------------------------------------------------- global variables ---
+const char *filenames[] = { "fonts/amiri-regular.ttf",
+                            "fonts/Vera.ttf" };
+size_t steps[] = { 64, 256, 1024, 4096, 16384 };
+size_t lookups = 1000000;
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    size_t i, j, step, count = 0, loaded = 0;
+    const char *filename = argc > 1 ? argv[1] : NULL;
+    char (*characters)[5];
+    uint32_t *codepoints;
+    texture_atlas_t *atlas;
+    texture_font_t *font;
+
+    for( i = 0; !filename && i < sizeof(filenames)/sizeof(filenames[0]); ++i )
+    {
+        FILE *file = fopen( filenames[i], "rb" );
+        if( file )
+        {
+            fclose( file );
+            filename = filenames[i];
+        }
+    }
+    if( !filename )
+    {
+        fprintf( stderr, "No font found\n" );
+        return EXIT_FAILURE;
+    }
+
+    atlas = texture_atlas_new( 4096, 4096, 1 );
+    font = texture_font_new_from_file( atlas, 8, filename );
+    if( !font )
+    {
+        return EXIT_FAILURE;
+    }
+
+    // Collect every printable character the font maps
+    codepoints = malloc( font->face->num_glyphs * sizeof(*codepoints) );
+    characters = malloc( font->face->num_glyphs * sizeof(*characters) );
+    if( !codepoints || !characters )
+    {
+        fprintf( stderr, "No more memory for allocating data\n" );
+        free( codepoints );
+        free( characters );
+        texture_font_delete( font );
+        texture_atlas_delete( atlas );
+        return EXIT_FAILURE;
+    }
+    count = texture_font_get_charcodes( font, codepoints,
+                                        font->face->num_glyphs );
+    for( i = 0; i < count; ++i )
+    {
+        utf32_to_utf8( codepoints[i], characters[i] );
+    }
+    free( codepoints );
+    if( !count )
+    {
+        fprintf( stderr, "%s maps no printable characters\n", filename );
+        free( characters );
+        texture_font_delete( font );
+        texture_atlas_delete( atlas );
+        return EXIT_FAILURE;
+    }
+
+    printf( "Font: %s (%zu printable characters)\n", filename, count );
+    printf( "%8s %12s %14s\n", "glyphs", "load (ms)", "lookup (ns)" );
+
+    for( step = 0; step < sizeof(steps)/sizeof(steps[0]); ++step )
+    {
+        size_t target = steps[step] < count ? steps[step] : count;
+        volatile texture_glyph_t *glyph;
+        clock_t start;
+        double load_time, lookup_time;
+
+        start = clock( );
+        for( ; loaded < target; ++loaded )
+        {
+            texture_font_load_glyph( font, characters[loaded] );
+        }
+        load_time = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+        // Pseudo random access pattern over loaded glyphs
+        start = clock( );
+        for( i = 0, j = 0; i < lookups; ++i )
+        {
+            j = (j * 1103515245 + 12345) & 0x7fffffff;
+            glyph = texture_font_get_glyph( font, characters[j % loaded] );
+        }
+        lookup_time = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+        (void) glyph;
+
+        printf( "%8zu %12.1f %14.1f\n", loaded,
+                1000.0 * load_time, 1e9 * lookup_time / lookups );
+
+        if( target == count )
+        {
+            break;
+        }
+    }
+
+    free( characters );
+    texture_font_delete( font );
+    texture_atlas_delete( atlas );
+
+    return 0;
+}
@@ -0,0 +1,288 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "distance-field.h"
+#include "edtaa3func.h"
+#include "texture-font.h"
+
+
+// ------------------------------------------------------- global variables ---
+const char *default_filenames[] = { "fonts/Vera.ttf",
+                                    "fonts/SourceSansPro-Regular.ttf",
+                                    "fonts/OldStandard-Regular.ttf",
+                                    "fonts/Lobster-Regular.ttf" };
+const unsigned int sizes[] = { 32, 64, 128 };
+const char *isa_names[] = { "scalar", "sse2", "avx2", "neon" };
+
+
+// ------------------------------------------------------------- glyph_t ---
+typedef struct {
+    unsigned int width, height;
+    unsigned char *coverage;
+    vector_t *segments;
+    int even_odd;
+} glyph_t;
+
+
+// -------------------------------------------------------------- benchmark ---
+size_t benchmark( FT_Library library, const char *filename, unsigned int size )
+{
+    glyph_t glyphs[95];
+    distance_field_workspace_t *workspace;
+    size_t i, j, count = 0, pixels = 0, differ = 0, max_error = 0, mismatch;
+    size_t exact_error = 0;
+    double double_time, scalar_time, float_time, exact_time, spread_time;
+    double outline_time;
+    double total_error = 0.0, outline_error = 0.0;
+    unsigned char *out, *scalar, *outline;
+    clock_t start;
+    FT_Face face;
+
+    if( FT_New_Face( library, filename, 0, &face ) ||
+        FT_Set_Pixel_Sizes( face, 0, size ) )
+    {
+        fprintf( stderr, "Cannot load %s\n", filename );
+        return 0;
+    }
+
+    // Coverage of printable ASCII, padded by a pixel as texture fonts do
+    for( i = 0; i < 95; ++i )
+    {
+        FT_Bitmap *bitmap;
+        float left, top;
+        glyph_t *glyph = glyphs + count;
+
+        if( FT_Load_Char( face, 0x20 + i, FT_LOAD_RENDER ) )
+            continue;
+        bitmap = &face->glyph->bitmap;
+        if( !bitmap->width || !bitmap->rows )
+            continue;
+        glyph->width = bitmap->width + 2;
+        glyph->height = bitmap->rows + 2;
+        glyph->coverage = calloc( glyph->width * glyph->height, 1 );
+        for( j = 0; j < bitmap->rows; ++j )
+        {
+            memcpy( glyph->coverage + (j + 1) * glyph->width + 1,
+                    bitmap->buffer + j * bitmap->pitch, bitmap->width );
+        }
+
+        // Outline of the same glyph, in pixels of its padded bitmap
+        glyph->segments = vector_new( sizeof(distance_field_segment_t) );
+        left = face->glyph->bitmap_left - 1.0f;
+        top = face->glyph->bitmap_top + 1.0f;
+        glyph->even_odd = 0;
+        if( !FT_Load_Char( face, 0x20 + i, FT_LOAD_NO_BITMAP ) &&
+            face->glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+        {
+            glyph->even_odd = face->glyph->outline.flags & FT_OUTLINE_EVEN_ODD_FILL;
+            texture_font_decompose_outline( &face->glyph->outline, left, top,
+                                            glyph->segments );
+        }
+        pixels += glyph->width * glyph->height;
+        ++count;
+    }
+    FT_Done_Face( face );
+
+    // Double precision, allocating per glyph
+    start = clock( );
+    for( i = 0; i < count; ++i )
+    {
+        free( make_distance_mapb( glyphs[i].coverage, glyphs[i].width, glyphs[i].height ) );
+    }
+    double_time = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+    // Single precision, from a reused workspace, with the scalar kernels
+    workspace = distance_field_workspace_new( 0 );
+    scalar = malloc( pixels );
+    out = malloc( pixels );
+    edtaa3f_simd( EDTAA3_SCALAR );
+    start = clock( );
+    for( i = 0, j = 0; i < count; j += glyphs[i].width * glyphs[i].height, ++i )
+    {
+        make_distance_mapb_workspace( glyphs[i].coverage, scalar + j,
+                                      glyphs[i].width, glyphs[i].height, workspace );
+    }
+    scalar_time = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+    // Same again with the best vector kernels, which must match exactly
+    edtaa3f_simd( -1 );
+    start = clock( );
+    for( i = 0, j = 0; i < count; j += glyphs[i].width * glyphs[i].height, ++i )
+    {
+        make_distance_mapb_workspace( glyphs[i].coverage, out + j,
+                                      glyphs[i].width, glyphs[i].height, workspace );
+    }
+    float_time = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+    for( i = 0, mismatch = 0; i < pixels; ++i )
+    {
+        mismatch += scalar[i] != out[i];
+    }
+
+    // Exact transform in linear time, compared with the iterative one
+    workspace->method = DISTANCE_FIELD_EXACT;
+    start = clock( );
+    for( i = 0, j = 0; i < count; j += glyphs[i].width * glyphs[i].height, ++i )
+    {
+        make_distance_mapb_workspace( glyphs[i].coverage, scalar + j,
+                                      glyphs[i].width, glyphs[i].height, workspace );
+    }
+    exact_time = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+    for( i = 0; i < pixels; ++i )
+    {
+        size_t error = abs( (int)scalar[i] - (int)out[i] );
+        if( error > exact_error )
+        {
+            exact_error = error;
+        }
+    }
+
+    // Iterative transform again, clamped to a 4 pixel spread
+    workspace->method = DISTANCE_FIELD_EDTAA3;
+    workspace->spread = 4;
+    start = clock( );
+    for( i = 0, j = 0; i < count; j += glyphs[i].width * glyphs[i].height, ++i )
+    {
+        make_distance_mapb_workspace( glyphs[i].coverage, scalar + j,
+                                      glyphs[i].width, glyphs[i].height, workspace );
+    }
+    spread_time = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+    // Same spread, measured from the outlines rather than their bitmaps
+    outline = malloc( pixels );
+    start = clock( );
+    for( i = 0, j = 0; i < count; j += glyphs[i].width * glyphs[i].height, ++i )
+    {
+        make_distance_map_outline( glyphs[i].segments->items,
+                                   vector_size( glyphs[i].segments ),
+                                   glyphs[i].even_odd, outline + j,
+                                   glyphs[i].width, glyphs[i].height, workspace );
+    }
+    outline_time = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+    for( i = 0; i < pixels; ++i )
+    {
+        outline_error += abs( (int)scalar[i] - (int)outline[i] );
+    }
+
+    // Compare single and double precision
+    for( i = 0, j = 0; i < count; j += glyphs[i].width * glyphs[i].height, ++i )
+    {
+        unsigned char *reference = make_distance_mapb( glyphs[i].coverage,
+                                                       glyphs[i].width,
+                                                       glyphs[i].height );
+        size_t k, n = glyphs[i].width * glyphs[i].height;
+        for( k = 0; k < n; ++k )
+        {
+            size_t error = abs( (int)reference[k] - (int)out[j + k] );
+            if( error )
+            {
+                ++differ;
+                total_error += error;
+                if( error > max_error )
+                {
+                    max_error = error;
+                }
+            }
+        }
+        free( reference );
+        free( glyphs[i].coverage );
+        vector_delete( glyphs[i].segments );
+    }
+
+    printf( "%-34s %5u %6zu %10.3f %10.3f %10.3f %8.2f %9.3f %8zu %8zu %10.3f %9zu %10.3f %10.3f %8.2f\n",
+            filename, size, count, 1000.0 * double_time / count,
+            1000.0 * scalar_time / count, 1000.0 * float_time / count,
+            double_time / float_time, 100.0 * differ / pixels, max_error,
+            mismatch, 1000.0 * exact_time / count, exact_error,
+            1000.0 * spread_time / count, 1000.0 * outline_time / count,
+            outline_error / pixels );
+
+    free( out );
+    free( scalar );
+    free( outline );
+    distance_field_workspace_delete( workspace );
+    return mismatch;
+}
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    FT_Library library;
+    size_t i, j, mismatch = 0;
+
+    if( FT_Init_FreeType( &library ) )
+    {
+        fprintf( stderr, "Cannot initialize FreeType\n" );
+        return EXIT_FAILURE;
+    }
+
+    printf( "Vector kernels: %s\n", isa_names[edtaa3f_simd( -1 )] );
+    printf( "%-34s %5s %6s %10s %10s %10s %8s %9s %8s %8s %10s %9s %10s %10s %8s\n",
+            "font", "px", "glyphs", "double ms", "scalar ms", "vector ms",
+            "speedup", "differ %", "max diff", "mismatch", "exact ms",
+            "exact max", "spread ms", "outline ms", "outl diff" );
+    for( i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i )
+    {
+        if( argc > 1 )
+        {
+            for( j = 1; j < (size_t)argc; ++j )
+            {
+                mismatch += benchmark( library, argv[j], sizes[i] );
+            }
+        }
+        else
+        {
+            for( j = 0; j < sizeof(default_filenames)/sizeof(default_filenames[0]); ++j )
+            {
+                mismatch += benchmark( library, default_filenames[j], sizes[i] );
+            }
+        }
+    }
+
+    FT_Done_FreeType( library );
+    if( mismatch )
+    {
+        fprintf( stderr, "Vector kernels differ from scalar in %zu texels\n", mismatch );
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "freetype-gl.h"
+
+
+// ------------------------------------------------------- global variables ---
+const char *filename = "fonts/Vera.ttf";
+const size_t frames = 1000;
+const size_t glyphs_per_frame = 64;
+
+
+// ------------------------------------------------------------- run_frames ---
+void run_frames( size_t size, uint32_t *codepoints, size_t count )
+{
+    size_t frame, i, failures = 0;
+    texture_atlas_t *atlas;
+    texture_font_t *font;
+    clock_t start;
+    double elapsed;
+
+    atlas = texture_atlas_new( size, size, 1 );
+    font = texture_font_new_from_file( atlas, 24, filename );
+    if( !font )
+    {
+        texture_atlas_delete( atlas );
+        return;
+    }
+
+    // Each frame shows a window of text drifting through the character set
+    srand( 1 );
+    start = clock( );
+    for( frame = 0; frame < frames; ++frame )
+    {
+        size_t first = (frame * glyphs_per_frame / 8) % count;
+        for( i = 0; i < glyphs_per_frame; ++i )
+        {
+            uint32_t codepoint = codepoints[(first + rand( ) % (2 * glyphs_per_frame)) % count];
+            if( !texture_font_get_glyph_utf32( font, codepoint ) )
+            {
+                ++failures;
+            }
+        }
+        texture_font_next_frame( font );
+    }
+    elapsed = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+    printf( "%6zu %10.1f %10zu %10zu %10zu %10.1f\n", size,
+            100.0 * font->stats.hits / (font->stats.hits + font->stats.misses),
+            font->stats.misses, font->stats.evictions, failures,
+            1000.0 * elapsed );
+
+    texture_font_delete( font );
+    texture_atlas_delete( atlas );
+}
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    size_t size, count = 0;
+    uint32_t *codepoints;
+    texture_atlas_t *atlas;
+    texture_font_t *font;
+
+    if( argc > 1 )
+    {
+        filename = argv[1];
+    }
+
+    // Collect every printable character the font maps
+    atlas = texture_atlas_new( 64, 64, 1 );
+    font = texture_font_new_from_file( atlas, 24, filename );
+    if( !font )
+    {
+        texture_atlas_delete( atlas );
+        return EXIT_FAILURE;
+    }
+    codepoints = malloc( font->face->num_glyphs * sizeof(uint32_t) );
+    if( !codepoints )
+    {
+        fprintf( stderr, "No more memory for allocating data\n" );
+        return EXIT_FAILURE;
+    }
+    count = texture_font_get_charcodes( font, codepoints,
+                                        font->face->num_glyphs );
+    texture_font_delete( font );
+    texture_atlas_delete( atlas );
+
+    printf( "Font: %s (%zu printable characters, %zu frames of %zu glyphs)\n",
+            filename, count, frames, glyphs_per_frame );
+    printf( "%6s %10s %10s %10s %10s %10s\n",
+            "atlas", "hits (%)", "misses", "evictions", "failures", "time (ms)" );
+
+    for( size = 256; size <= 1024; size *= 2 )
+    {
+        run_frames( size, codepoints, count );
+    }
+
+    free( codepoints );
+    return 0;
+}
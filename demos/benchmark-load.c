@@ -0,0 +1,135 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freetype-gl.h"
+#include "utf8-utils.h"
+
+
+// ------------------------------------------------------- global variables ---
+const char *default_filenames[] = { "fonts/Vera.ttf",
+                                    "fonts/amiri-regular.ttf" };
+
+
+// ------------------------------------------------------------- load_font ---
+void load_font( const char *filename )
+{
+    size_t i, quarter, count = 0, loaded = 0;
+    char (*characters)[5];
+    uint32_t *codepoints;
+    texture_atlas_t *atlas;
+    texture_font_t *font;
+
+    atlas = texture_atlas_new( 4096, 4096, 1 );
+    font = texture_font_new_from_file( atlas, 12, filename );
+    if( !font )
+    {
+        texture_atlas_delete( atlas );
+        return;
+    }
+
+    // Collect every printable character the font maps
+    codepoints = malloc( font->face->num_glyphs * sizeof(*codepoints) );
+    characters = malloc( font->face->num_glyphs * sizeof(*characters) );
+    if( !codepoints || !characters )
+    {
+        fprintf( stderr, "No more memory for allocating data\n" );
+        free( codepoints );
+        free( characters );
+        texture_font_delete( font );
+        texture_atlas_delete( atlas );
+        return;
+    }
+    count = texture_font_get_charcodes( font, codepoints,
+                                        font->face->num_glyphs );
+    for( i = 0; i < count; ++i )
+    {
+        utf32_to_utf8( codepoints[i], characters[i] );
+    }
+    free( codepoints );
+
+    printf( "Font: %s (%zu printable characters)\n", filename, count );
+    printf( "%8s %12s %16s\n", "glyphs", "load (ms)", "per glyph (us)" );
+
+    // Time each quarter separately: linear loading keeps them equal
+    for( quarter = 1; quarter <= 4; ++quarter )
+    {
+        size_t target = count * quarter / 4;
+        size_t first = loaded;
+        clock_t start = clock( );
+        double elapsed;
+
+        for( ; loaded < target; ++loaded )
+        {
+            texture_font_load_glyph( font, characters[loaded] );
+        }
+        elapsed = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+        printf( "%8zu %12.1f %16.2f\n", loaded, 1000.0 * elapsed,
+                loaded > first ? 1e6 * elapsed / (loaded - first) : 0.0 );
+    }
+
+    printf( "Kerning pairs: %zu\n\n", font->kerning_index.count );
+
+    free( characters );
+    texture_font_delete( font );
+    texture_atlas_delete( atlas );
+}
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    int i;
+
+    if( argc > 1 )
+    {
+        for( i = 1; i < argc; ++i )
+        {
+            load_font( argv[i] );
+        }
+    }
+    else
+    {
+        for( i = 0; i < sizeof(default_filenames)/sizeof(default_filenames[0]); ++i )
+        {
+            load_font( default_filenames[i] );
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "texture-atlas.h"
+
+
+// ------------------------------------------------------- global variables ---
+const char *default_filenames[] = { "fonts/Vera.ttf",
+                                    "fonts/SourceSansPro-Regular.ttf",
+                                    "fonts/amiri-regular.ttf" };
+const size_t pixel_sizes[] = { 12, 24, 48 };
+const char *packer_names[] = { "skyline", "maxrects", "guillotine", "shelf" };
+const size_t atlas_size = 1024;
+const size_t batch_size = 256;
+
+
+// ---------------------------------------------------------- compare_sizes ---
+int compare_sizes( const void *a, const void *b )
+{
+    return ((const ivec2 *) b)->y - ((const ivec2 *) a)->y;
+}
+
+
+// ------------------------------------------------------------ glyph_sizes ---
+/* Collects the padded bitmap size of every glyph at every pixel size */
+vector_t * glyph_sizes( const char *filename )
+{
+    FT_Library library;
+    FT_Face face;
+    vector_t *sizes = vector_new( sizeof(ivec2) );
+    size_t i;
+    FT_Long index;
+
+    if( FT_Init_FreeType( &library ) )
+    {
+        return sizes;
+    }
+    if( FT_New_Face( library, filename, 0, &face ) )
+    {
+        fprintf( stderr, "Unable to load font %s\n", filename );
+        FT_Done_FreeType( library );
+        return sizes;
+    }
+    for( i = 0; i < sizeof(pixel_sizes)/sizeof(pixel_sizes[0]); ++i )
+    {
+        FT_Set_Pixel_Sizes( face, 0, pixel_sizes[i] );
+        for( index = 0; index < face->num_glyphs; ++index )
+        {
+            ivec2 size;
+            if( FT_Load_Glyph( face, index, FT_LOAD_RENDER ) )
+            {
+                continue;
+            }
+            // One pixel of padding, as texture fonts do
+            size.x = face->glyph->bitmap.width + 1;
+            size.y = face->glyph->bitmap.rows + 1;
+            vector_push_back( sizes, &size );
+        }
+    }
+    FT_Done_Face( face );
+    FT_Done_FreeType( library );
+    return sizes;
+}
+
+
+// ------------------------------------------------------------------- pack ---
+/* Fills an atlas with the glyph sizes, cycling through them until 100
+ * regions in a row do not fit */
+void pack( const vector_t *sizes, texture_atlas_packer_t packer )
+{
+    texture_atlas_t *atlas;
+    size_t i, count = 0, missed = 0;
+    clock_t start;
+    double elapsed;
+
+    atlas = texture_atlas_new_with_packer( atlas_size, atlas_size, 1, packer );
+    start = clock( );
+    for( i = 0; missed < 100; i = (i + 1) % sizes->size )
+    {
+        const ivec2 *size = (const ivec2 *) vector_get( sizes, i );
+        ivec4 region = texture_atlas_get_region( atlas, size->x, size->y );
+        if( region.x < 0 )
+        {
+            ++missed;
+            continue;
+        }
+        missed = 0;
+        ++count;
+    }
+    elapsed = (clock( ) - start) / (double) CLOCKS_PER_SEC;
+
+    printf( "  %-12s %8zu %11.1f%% %10.1f %16.2f\n", packer_names[packer],
+            count, 100.0 * atlas->used / (double)(atlas_size * atlas_size),
+            1000.0 * elapsed, count ? 1e6 * elapsed / count : 0.0 );
+    texture_atlas_delete( atlas );
+}
+
+
+// -------------------------------------------------------------- pack_font ---
+void pack_font( const char *filename )
+{
+    vector_t *sizes = glyph_sizes( filename );
+    texture_atlas_packer_t packer;
+    size_t i;
+
+    if( !sizes->size )
+    {
+        vector_delete( sizes );
+        return;
+    }
+
+    printf( "Font: %s (%zu glyph sizes, %zux%zu atlas)\n",
+            filename, sizes->size, atlas_size, atlas_size );
+    printf( "  %-12s %8s %12s %10s %16s\n",
+            "packer", "regions", "occupancy", "time (ms)", "per region (us)" );
+    printf( " font order\n" );
+    for( packer = PACKER_SKYLINE; packer <= PACKER_SHELF; ++packer )
+    {
+        pack( sizes, packer );
+    }
+
+    // Glyphs loaded in batches are packed tallest first
+    for( i = 0; i < sizes->size; i += batch_size )
+    {
+        size_t count = sizes->size - i < batch_size ? sizes->size - i : batch_size;
+        qsort( (char *) sizes->items + i * sizes->item_size, count,
+               sizes->item_size, compare_sizes );
+    }
+    printf( " batches of %zu, tallest first\n", batch_size );
+    for( packer = PACKER_SKYLINE; packer <= PACKER_SHELF; ++packer )
+    {
+        pack( sizes, packer );
+    }
+    printf( "\n" );
+
+    vector_delete( sizes );
+}
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    int i;
+
+    if( argc > 1 )
+    {
+        for( i = 1; i < argc; ++i )
+        {
+            pack_font( argv[i] );
+        }
+    }
+    else
+    {
+        for( i = 0; i < sizeof(default_filenames)/sizeof(default_filenames[0]); ++i )
+        {
+            pack_font( default_filenames[i] );
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freetype-gl.h"
+#include "utf8-utils.h"
+
+
+// ------------------------------------------------------- global variables ---
+const char *default_filename = "fonts/Vera.ttf";
+const size_t max_characters = 512;
+
+
+// ------------------------------------------------------------------ now ---
+double now( void )
+{
+    // Wall clock time, clock() would add up the time of every thread
+    struct timespec ts;
+    timespec_get( &ts, TIME_UTC );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+// ---------------------------------------------------------------- checksum ---
+uint32_t checksum( const texture_atlas_t *atlas )
+{
+    size_t i, size = atlas->width * atlas->height * atlas->depth;
+    uint32_t hash = 2166136261u;
+
+    for( i = 0; i < size; ++i )
+    {
+        hash = (hash ^ atlas->data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+
+// ------------------------------------------------------------------- main ---
+int main( int argc, char **argv )
+{
+    const char *filename = argc > 1 ? argv[1] : default_filename;
+    size_t max_threads = argc > 2 ? (size_t) atoi( argv[2] ) : 8;
+    size_t i, threads, count = 0, length = 0, missed;
+    uint32_t *codepoints;
+    char *characters = NULL;
+    double start, elapsed, serial = 0;
+    uint32_t reference = 0, hash;
+    texture_atlas_t *atlas;
+    texture_font_t *font;
+
+    printf( "Signed distance field warm-up of %s\n", filename );
+    printf( "%8s %8s %12s %10s %10s\n",
+            "threads", "glyphs", "time (ms)", "speedup", "atlas" );
+
+    for( threads = 1; threads <= max_threads; threads *= 2 )
+    {
+        atlas = texture_atlas_new( 2048, 2048, 1 );
+        font = texture_font_new_from_file( atlas, 32, filename );
+        if( !font )
+        {
+            texture_atlas_delete( atlas );
+            return EXIT_FAILURE;
+        }
+        font->rendermode = RENDER_SIGNED_DISTANCE_FIELD;
+        font->threads = threads;
+
+        // Collect the first printable characters the font maps
+        if( threads == 1 )
+        {
+            codepoints = malloc( max_characters * sizeof(*codepoints) );
+            characters = malloc( 4 * max_characters + 1 );
+            if( !codepoints || !characters )
+            {
+                fprintf( stderr, "No more memory for allocating data\n" );
+                return EXIT_FAILURE;
+            }
+            count = texture_font_get_charcodes( font, codepoints,
+                                                max_characters );
+            characters[0] = 0;
+            for( i = 0; i < count; ++i )
+            {
+                length += utf32_to_utf8( codepoints[i],
+                                         characters + length );
+            }
+            free( codepoints );
+        }
+
+        start = now( );
+        missed = texture_font_load_glyphs( font, characters );
+        elapsed = now( ) - start;
+
+        // Every thread count must give the very same atlas
+        hash = checksum( atlas );
+        if( threads == 1 )
+        {
+            serial = elapsed;
+            reference = hash;
+        }
+        printf( "%8zu %8zu %12.1f %9.2fx %10s\n", threads, count - missed,
+                1000.0 * elapsed, serial / elapsed,
+                hash == reference ? "same" : "DIFFERENT" );
+
+        texture_font_delete( font );
+        texture_atlas_delete( atlas );
+    }
+
+    free( characters );
+    return 0;
+}
@@ -114,7 +114,6 @@ console_new( void )
     self->pen.x = self->pen.y = 0;
 
     self->atlas = texture_atlas_new( 512, 512, 1 );
-    glGenTextures( 1, &self->atlas->id );
 
     vec4 white = {{1,1,1,1}};
     vec4 black = {{0,0,0,1}};
@@ -324,14 +323,7 @@ console_render( console_t *self )
 
     if( self->lines->size || self->prompt[0] != '\0' || self->input[0] != '\0' )
     {
-        glBindTexture( GL_TEXTURE_2D, self->atlas->id );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-        glTexImage2D( GL_TEXTURE_2D, 0, GL_RED, self->atlas->width,
-                      self->atlas->height, 0, GL_RED, GL_UNSIGNED_BYTE,
-                      self->atlas->data );
+        texture_atlas_upload( self->atlas );
     }
 
     // Cursor (we use the black character (NULL) as texture )
@@ -32,9 +32,28 @@
  * ============================================================================
  */
 #include <float.h>
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "edtaa3func.h"
+#include "distance-field.h"
+
+// Side in pixels of the cells of the grid of outline curves
+#define DISTANCE_FIELD_CELL 4
+
+// Largest distance in pixels between a cubic curve and its quadratic pieces
+#define DISTANCE_FIELD_TOLERANCE 0.01
+
+/* Quadratic curve of an outline, monotonic in y, lines having their control
+ * point halfway */
+typedef struct distance_field_curve_t
+{
+    float x0, y0, cx, cy, x1, y1;
+    float xmin, ymin, xmax, ymax;
+    int line;
+    int visit;
+} distance_field_curve_t;
 
 
 double *
@@ -130,3 +149,527 @@ make_distance_mapb( unsigned char *img,
 
     return out;
 }
+
+distance_field_workspace_t *
+distance_field_workspace_new( size_t capacity )
+{
+    distance_field_workspace_t *self =
+        (distance_field_workspace_t *) calloc( 1, sizeof(distance_field_workspace_t) );
+    if( self == NULL )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    distance_field_workspace_reserve( self, capacity );
+    self->segments = vector_new( sizeof(distance_field_segment_t) );
+    self->curves = vector_new( sizeof(distance_field_curve_t) );
+    self->grid = vector_new( sizeof(int) );
+    return self;
+}
+
+void
+distance_field_workspace_delete( distance_field_workspace_t *self )
+{
+    // All buffers but the scratch one share the allocation of gx
+    free( self->gx );
+    free( self->scratch );
+    vector_delete( self->segments );
+    vector_delete( self->curves );
+    vector_delete( self->grid );
+    free( self );
+}
+
+void
+distance_field_workspace_reserve( distance_field_workspace_t *self,
+                                  size_t capacity )
+{
+    float *floats;
+
+    if( capacity <= self->capacity )
+        return;
+
+    // Grow by half again at least, so that glyphs of increasing sizes
+    // do not reallocate every time
+    if( capacity < self->capacity + self->capacity/2 )
+        capacity = self->capacity + self->capacity/2;
+    free( self->gx );
+    floats = (float *) malloc( capacity * (5*sizeof(float) + 2*sizeof(short)) );
+    if( floats == NULL )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    self->capacity = capacity;
+    self->gx      = floats;
+    self->gy      = floats + capacity;
+    self->outside = floats + 2*capacity;
+    self->inside  = floats + 3*capacity;
+    self->data    = floats + 4*capacity;
+    self->xdist   = (short *) (floats + 5*capacity);
+    self->ydist   = self->xdist + capacity;
+}
+
+// Distances of the pixels of data to its edges, with the transform of the
+// workspace
+static void
+distance_field_transform( const float *data,
+                          unsigned int width, unsigned int height,
+                          distance_field_workspace_t *workspace, float *dist )
+{
+    // Within the spread, distances propagate from pixel to pixel through
+    // closer ones, up to one pixel and a half more with the edge correction
+    float limit = workspace->spread > 0 ? workspace->spread + 2.0f : 1000000.0f;
+
+    if( workspace->method == DISTANCE_FIELD_EXACT )
+        edtexactf( data, workspace->gx, workspace->gy, width, height,
+                   workspace->xdist, workspace->ydist, dist, limit,
+                   workspace->scratch );
+    else
+        edtaa3f( data, workspace->gx, workspace->gy, width, height,
+                 workspace->xdist, workspace->ydist, dist, limit,
+                 workspace->scratch );
+}
+
+float *
+make_distance_mapf( float *data,
+                    unsigned int width, unsigned int height,
+                    distance_field_workspace_t *workspace )
+{
+    size_t n = (size_t) width * height;
+    size_t scratch_size = edtaa3f_scratch( width, height );
+    float vmin;
+
+    distance_field_workspace_reserve( workspace, n );
+    if( scratch_size > workspace->scratch_size )
+    {
+        free( workspace->scratch );
+        workspace->scratch = (float *) malloc( scratch_size * sizeof(float) );
+        if( workspace->scratch == NULL )
+        {
+            fprintf( stderr,
+                     "line %d: No more memory for allocating data\n", __LINE__ );
+            exit( EXIT_FAILURE );
+        }
+        workspace->scratch_size = scratch_size;
+    }
+
+    // Compute outside = edtaa3(bitmap); % Transform background (0's)
+    memset( workspace->gx, 0, sizeof(float)*n );
+    memset( workspace->gy, 0, sizeof(float)*n );
+    computegradientf( data, width, height, workspace->gx, workspace->gy );
+    distance_field_transform( data, width, height, workspace,
+                              workspace->outside );
+    edtaa3f_clamp( workspace->outside, n );
+
+    // Compute inside = edtaa3(1-bitmap); % Transform foreground (1's)
+    memset( workspace->gx, 0, sizeof(float)*n );
+    memset( workspace->gy, 0, sizeof(float)*n );
+    edtaa3f_invert( data, n );
+    computegradientf( data, width, height, workspace->gx, workspace->gy );
+    distance_field_transform( data, width, height, workspace,
+                              workspace->inside );
+    edtaa3f_clamp( workspace->inside, n );
+
+    // distmap = outside - inside; % Bipolar distance field
+    vmin = fabsf( edtaa3f_subtract( workspace->outside, workspace->inside, n ) );
+    if( workspace->spread > 0 )
+        vmin = workspace->spread;
+    edtaa3f_normalize( workspace->outside, data, n, vmin );
+    return data;
+}
+
+void
+make_distance_mapb_workspace( const unsigned char *img, unsigned char *out,
+                              unsigned int width, unsigned int height,
+                              distance_field_workspace_t *workspace )
+{
+    size_t i, n = (size_t) width * height;
+    float img_min = FLT_MAX;
+    float img_max = FLT_MIN;
+    float *data;
+
+    distance_field_workspace_reserve( workspace, n );
+    data = workspace->data;
+
+    // find minimimum and maximum values
+    for( i=0; i<n; ++i )
+    {
+        float v = img[i];
+        if (v > img_max)
+            img_max = v;
+        if (v < img_min)
+            img_min = v;
+    }
+
+    // Map values from 0 - 255 to 0.0 - 1.0
+    for( i=0; i<n; ++i )
+        data[i] = (img[i]-img_min)/img_max;
+
+    make_distance_mapf( data, width, height, workspace );
+
+    // map values from 0.0 - 1.0 to 0 - 255
+    edtaa3f_bytes( data, out, n );
+}
+
+// Appends a quadratic curve to curves, split at its extremum in y so that
+// crossings with rows are found with a single root
+static void
+distance_field_add_quadratic( vector_t *curves,
+                              float x0, float y0, float cx, float cy,
+                              float x1, float y1, int line )
+{
+    distance_field_curve_t curve;
+    float a = y0 - 2*cy + y1;
+    float t = a != 0 ? (y0 - cy) / a : 0;
+
+    if( !line && t > 0 && t < 1 )
+    {
+        // de Casteljau split at t, both halves sharing the same end point
+        float ax = x0 + t*(cx - x0), ay = y0 + t*(cy - y0);
+        float bx = cx + t*(x1 - cx), by = cy + t*(y1 - cy);
+        float mx = ax + t*(bx - ax), my = ay + t*(by - ay);
+        distance_field_add_quadratic( curves, x0, y0, ax, ay, mx, my, 0 );
+        distance_field_add_quadratic( curves, mx, my, bx, by, x1, y1, 0 );
+        return;
+    }
+    curve.x0 = x0; curve.y0 = y0;
+    curve.cx = cx; curve.cy = cy;
+    curve.x1 = x1; curve.y1 = y1;
+    curve.xmin = fminf( fminf( x0, cx ), x1 );
+    curve.ymin = fminf( fminf( y0, cy ), y1 );
+    curve.xmax = fmaxf( fmaxf( x0, cx ), x1 );
+    curve.ymax = fmaxf( fmaxf( y0, cy ), y1 );
+    curve.line = line;
+    curve.visit = -1;
+    vector_push_back( curves, &curve );
+}
+
+// Appends a cubic curve to curves as quadratic ones, the error of a single
+// quadratic being sqrt(3)/36 |p3 - 3p2 + 3p1 - p0| and dropping with the
+// cube of the number of pieces
+static void
+distance_field_add_cubic( vector_t *curves, const float *x, const float *y )
+{
+    float dx = x[3] - 3*x[2] + 3*x[1] - x[0];
+    float dy = y[3] - 3*y[2] + 3*y[1] - y[0];
+    double error = sqrt( 3.0 ) / 36.0 * sqrt( dx*dx + dy*dy );
+    int i, n = (int) ceil( cbrt( error / DISTANCE_FIELD_TOLERANCE ) );
+    float qx[2], qy[2], tx[2], ty[2];
+
+    if( n < 1 )
+        n = 1;
+    else if( n > 64 )
+        n = 64;
+
+    qx[0] = x[0]; qy[0] = y[0];
+    tx[0] = 3*(x[1] - x[0]); ty[0] = 3*(y[1] - y[0]);
+    for( i = 1; i <= n; ++i )
+    {
+        float t = (float) i / n, s = 1 - t, h = 1.0f / (3*n);
+        float x1, y1, x2, y2;
+
+        qx[1] = s*s*s*x[0] + 3*s*s*t*x[1] + 3*s*t*t*x[2] + t*t*t*x[3];
+        qy[1] = s*s*s*y[0] + 3*s*s*t*y[1] + 3*s*t*t*y[2] + t*t*t*y[3];
+        tx[1] = 3*(s*s*(x[1] - x[0]) + 2*s*t*(x[2] - x[1]) + t*t*(x[3] - x[2]));
+        ty[1] = 3*(s*s*(y[1] - y[0]) + 2*s*t*(y[2] - y[1]) + t*t*(y[3] - y[2]));
+        if( i == n )
+        {
+            qx[1] = x[3]; qy[1] = y[3];
+        }
+
+        // Control points of the piece, merged into a quadratic one
+        x1 = qx[0] + h*tx[0]; y1 = qy[0] + h*ty[0];
+        x2 = qx[1] - h*tx[1]; y2 = qy[1] - h*ty[1];
+        distance_field_add_quadratic( curves, qx[0], qy[0],
+                                      (3*(x1 + x2) - qx[0] - qx[1]) / 4,
+                                      (3*(y1 + y2) - qy[0] - qy[1]) / 4,
+                                      qx[1], qy[1], 0 );
+        qx[0] = qx[1]; qy[0] = qy[1];
+        tx[0] = tx[1]; ty[0] = ty[1];
+    }
+}
+
+// Squared distance from (px,py) to the segment from (x0,y0) to (x1,y1)
+static double
+distance_field_line2( double px, double py,
+                      double x0, double y0, double x1, double y1 )
+{
+    double dx = x1 - x0, dy = y1 - y0;
+    double l = dx*dx + dy*dy;
+    double t = l > 0 ? ((px - x0)*dx + (py - y0)*dy) / l : 0;
+
+    if( t < 0 ) t = 0;
+    else if( t > 1 ) t = 1;
+    dx = x0 + t*dx - px;
+    dy = y0 + t*dy - py;
+    return dx*dx + dy*dy;
+}
+
+// Squared distance from (px,py) to a curve, closest points being the ends or
+// roots of the cubic (B(t) - p).B'(t) = 0
+static double
+distance_field_curve2( const distance_field_curve_t *curve,
+                       double px, double py )
+{
+    double ax = curve->cx - curve->x0, ay = curve->cy - curve->y0;
+    double bx = curve->x0 - 2*curve->cx + curve->x1;
+    double by = curve->y0 - 2*curve->cy + curve->y1;
+    double mx = curve->x0 - px, my = curve->y0 - py;
+    double a3 = bx*bx + by*by;
+    double roots[3], b, c, d, p, q, disc, best;
+    int i, n = 0;
+
+    // Control point (nearly) halfway, as for lines
+    if( curve->line || a3 < 1e-6 )
+        return distance_field_line2( px, py, curve->x0, curve->y0,
+                                     curve->x1, curve->y1 );
+
+    b = 3*(ax*bx + ay*by) / a3;
+    c = (2*(ax*ax + ay*ay) + mx*bx + my*by) / a3;
+    d = (mx*ax + my*ay) / a3;
+
+    // Depressed cubic u^3 + pu + q = 0 with t = u - b/3
+    p = c - b*b/3;
+    q = 2*b*b*b/27 - b*c/3 + d;
+    disc = q*q/4 + p*p*p/27;
+    if( disc > 0 )
+    {
+        double r = sqrt( disc );
+        roots[n++] = cbrt( -q/2 + r ) + cbrt( -q/2 - r ) - b/3;
+    }
+    else if( p < 0 )
+    {
+        double m = 2*sqrt( -p/3 );
+        double k = 3*q / (p*m);
+        double theta;
+        if( k < -1 ) k = -1;
+        else if( k > 1 ) k = 1;
+        theta = acos( k ) / 3;
+        for( i = 0; i < 3; ++i )
+            roots[n++] = m*cos( theta - 2.0943951023931957*i ) - b/3;
+    }
+    else
+    {
+        roots[n++] = -b/3;
+    }
+
+    best = mx*mx + my*my;
+    d = (curve->x1 - px)*(curve->x1 - px) + (curve->y1 - py)*(curve->y1 - py);
+    if( d < best )
+        best = d;
+    for( i = 0; i < n; ++i )
+    {
+        double t = roots[i], x, y;
+        if( t <= 0 || t >= 1 )
+            continue;
+        x = mx + t*(2*ax + t*bx);
+        y = my + t*(2*ay + t*by);
+        d = x*x + y*y;
+        if( d < best )
+            best = d;
+    }
+    return best;
+}
+
+// Abscissa at which a monotonic curve crosses the row at y
+static float
+distance_field_crossing( const distance_field_curve_t *curve, float y )
+{
+    double a = curve->y0 - 2*curve->cy + curve->y1;
+    double b = 2*(curve->cy - curve->y0);
+    double c = curve->y0 - y;
+    double t;
+
+    if( curve->line || fabs( a ) < 1e-9 )
+    {
+        t = (y - curve->y0) / (curve->y1 - curve->y0);
+    }
+    else
+    {
+        // Root of the stable form falling within [0,1]
+        double r = sqrt( fmax( b*b - 4*a*c, 0 ) );
+        double s = b >= 0 ? -(b + r) / 2 : (r - b) / 2;
+        double t0 = s / a, t1 = s != 0 ? c / s : t0;
+        t = fabs( t0 - 0.5 ) <= fabs( t1 - 0.5 ) ? t0 : t1;
+    }
+    if( t < 0 ) t = 0;
+    else if( t > 1 ) t = 1;
+    return (float) ((1-t)*(1-t)*curve->x0 + 2*t*(1-t)*curve->cx + t*t*curve->x1);
+}
+
+void
+make_distance_map_outline( const distance_field_segment_t *segments,
+                           size_t count, int even_odd, unsigned char *out,
+                           unsigned int width, unsigned int height,
+                           distance_field_workspace_t *workspace )
+{
+    size_t i, n = (size_t) width * height, ncurves;
+    int gw = (width + DISTANCE_FIELD_CELL - 1) / DISTANCE_FIELD_CELL;
+    int gh = (height + DISTANCE_FIELD_CELL - 1) / DISTANCE_FIELD_CELL;
+    int entries = 0, *cells, *indices = NULL, x, y, j, k;
+    float limit = workspace->spread > 0 ? workspace->spread : FLT_MAX;
+    float grow = workspace->spread > 0 ? workspace->spread : 0;
+    int rings = workspace->spread > 0 ? 0 : (gw > gh ? gw : gh);
+    float vmin = 0, *xs, *dirs;
+    distance_field_curve_t *curves;
+
+    vector_clear( workspace->curves );
+    for( i = 0; i < count; ++i )
+    {
+        const distance_field_segment_t *s = segments + i;
+        if( s->points == 4 )
+            distance_field_add_cubic( workspace->curves, s->x, s->y );
+        else if( s->points == 3 )
+            distance_field_add_quadratic( workspace->curves, s->x[0], s->y[0],
+                                          s->x[1], s->y[1], s->x[2], s->y[2], 0 );
+        else
+            distance_field_add_quadratic( workspace->curves, s->x[0], s->y[0],
+                                          (s->x[0] + s->x[1]) / 2,
+                                          (s->y[0] + s->y[1]) / 2,
+                                          s->x[1], s->y[1], 1 );
+    }
+    ncurves = vector_size( workspace->curves );
+    curves = (distance_field_curve_t *) workspace->curves->items;
+    if( !n )
+        return;
+    if( !ncurves )
+    {
+        // Nothing but background
+        memset( out, 0, n );
+        return;
+    }
+
+    // Row crossings are kept in gx and gy, distances in outside
+    distance_field_workspace_reserve( workspace, n > ncurves ? n : ncurves );
+    xs = workspace->gx;
+    dirs = workspace->gy;
+
+    // Cells of the curve bounding boxes, cell c holding the indices from
+    // cells[c] to cells[c+1]. With a spread, boxes are grown by it so that
+    // the cell of a pixel alone lists every curve closer than the spread.
+    vector_resize( workspace->grid, gw*gh + 2 );
+    cells = (int *) workspace->grid->items;
+    memset( cells, 0, (gw*gh + 2) * sizeof(int) );
+    for( k = 0; k < 2; ++k )
+    {
+        if( k )
+        {
+            for( j = 2; j < gw*gh + 2; ++j )
+                cells[j] += cells[j-1];
+            vector_resize( workspace->grid, gw*gh + 2 + entries );
+            cells = (int *) workspace->grid->items;
+            indices = cells + gw*gh + 2;
+        }
+        for( i = 0; i < ncurves; ++i )
+        {
+            int x0 = (int) floorf( (curves[i].xmin - grow) / DISTANCE_FIELD_CELL );
+            int y0 = (int) floorf( (curves[i].ymin - grow) / DISTANCE_FIELD_CELL );
+            int x1 = (int) floorf( (curves[i].xmax + grow) / DISTANCE_FIELD_CELL );
+            int y1 = (int) floorf( (curves[i].ymax + grow) / DISTANCE_FIELD_CELL );
+            if( x0 < 0 ) x0 = 0;
+            if( y0 < 0 ) y0 = 0;
+            if( x1 >= gw ) x1 = gw - 1;
+            if( y1 >= gh ) y1 = gh - 1;
+            for( y = y0; y <= y1; ++y )
+                for( x = x0; x <= x1; ++x )
+                {
+                    if( k )
+                        indices[cells[y*gw + x + 1]++] = (int) i;
+                    else
+                        ++cells[y*gw + x + 2], ++entries;
+                }
+        }
+    }
+
+    for( y = 0; y < (int) height; ++y )
+    {
+        float py = y + 0.5f;
+        int crossings = 0, winding = 0, c;
+
+        // Crossings of the row, sorted by abscissa, the winding number
+        // counting those right of the pixel
+        for( i = 0; i < ncurves; ++i )
+        {
+            const distance_field_curve_t *curve = curves + i;
+            float px, dir;
+            if( curve->y0 <= py && py < curve->y1 )
+                dir = 1;
+            else if( curve->y1 <= py && py < curve->y0 )
+                dir = -1;
+            else
+                continue;
+            px = distance_field_crossing( curve, py );
+            for( j = crossings; j > 0 && xs[j-1] > px; --j )
+            {
+                xs[j] = xs[j-1];
+                dirs[j] = dirs[j-1];
+            }
+            xs[j] = px;
+            dirs[j] = dir;
+            winding += (int) dir;
+            ++crossings;
+        }
+
+        for( x = 0, c = 0; x < (int) width; ++x )
+        {
+            int pixel = y*width + x, r, inside;
+            int cx = x / DISTANCE_FIELD_CELL, cy = y / DISTANCE_FIELD_CELL;
+            float px = x + 0.5f;
+            double best = (double) limit * limit;
+
+            for( ; c < crossings && xs[c] <= px; ++c )
+                winding -= (int) dirs[c];
+            inside = even_odd ? winding & 1 : winding != 0;
+
+            // Rings of cells around the pixel, until no curve of the next
+            // one can be closer
+            for( r = 0; r <= rings; ++r )
+            {
+                double ring = (double) (r - 1) * DISTANCE_FIELD_CELL;
+                if( r > 0 && ring*ring >= best )
+                    break;
+                for( j = cy - r; j <= cy + r; ++j )
+                {
+                    int step = (j == cy - r || j == cy + r) ? 1 : 2*r;
+                    if( j < 0 || j >= gh )
+                        continue;
+                    for( k = cx - r; k <= cx + r; k += step )
+                    {
+                        int e;
+                        if( k < 0 || k >= gw )
+                            continue;
+                        for( e = cells[j*gw + k]; e < cells[j*gw + k + 1]; ++e )
+                        {
+                            distance_field_curve_t *curve = curves + indices[e];
+                            float dx = fmaxf( fmaxf( curve->xmin - px, px - curve->xmax ), 0 );
+                            float dy = fmaxf( fmaxf( curve->ymin - py, py - curve->ymax ), 0 );
+                            double d;
+                            if( curve->visit == pixel )
+                                continue;
+                            curve->visit = pixel;
+                            if( (double) dx*dx + (double) dy*dy >= best )
+                                continue;
+                            d = distance_field_curve2( curve, px, py );
+                            if( d < best )
+                                best = d;
+                        }
+                    }
+                }
+            }
+
+            // Positive outside as with bitmaps
+            workspace->outside[pixel] = inside ? -(float) sqrt( best )
+                                               : (float) sqrt( best );
+            if( workspace->outside[pixel] < vmin )
+                vmin = workspace->outside[pixel];
+        }
+    }
+
+    vmin = workspace->spread > 0 ? workspace->spread : fabsf( vmin );
+    if( vmin <= 0 )
+        vmin = 1;
+    edtaa3f_normalize( workspace->outside, workspace->data, n, vmin );
+    edtaa3f_bytes( workspace->data, out, n );
+}
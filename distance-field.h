@@ -34,6 +34,9 @@
 #ifndef __DISTANCE_FIELD_H__
 #define __DISTANCE_FIELD_H__
 
+#include <stdlib.h>
+#include "vector.h"
+
 #ifdef __cplusplus
 extern "C" {
 namespace ftgl {
@@ -66,6 +69,207 @@ namespace ftgl {
  * @{
  */
 
+/**
+ * Transforms computing the distances to the edges of a bitmap.
+ */
+typedef enum distance_field_method_t
+{
+    /**
+     * Iterative anti-aliased transform of Gustavson, sweeping the image until
+     * no distance changes (default)
+     */
+    DISTANCE_FIELD_EDTAA3,
+
+    /**
+     * Exact Euclidean transform of Felzenszwalb and Huttenlocher with the
+     * same anti-aliasing correction and a single sweep, in a time linear in
+     * the number of pixels
+     */
+    DISTANCE_FIELD_EXACT,
+
+    /**
+     * Exact distances to the lines and curves of the outline of a glyph,
+     * found through a grid of the segments instead of from its bitmap. It
+     * has none of the errors anti-aliased coverage leaves at corners and
+     * thin features, and with a spread only the curves within reach of each
+     * pixel are measured. Only make_distance_map_outline computes it,
+     * bitmaps falling back to DISTANCE_FIELD_EDTAA3.
+     */
+    DISTANCE_FIELD_OUTLINE
+} distance_field_method_t;
+
+/**
+ * Line or Bézier curve of an outline, in pixels of the distance field with y
+ * pointing down, pixel centers lying at half integers.
+ */
+typedef struct distance_field_segment_t
+{
+    /**
+     * 2 for a line, 3 for a quadratic and 4 for a cubic curve
+     */
+    int points;
+
+    /**
+     * Start point, control points and end point
+     */
+    float x[4], y[4];
+
+} distance_field_segment_t;
+
+/**
+ * Scratch buffers reused by make_distance_mapf across glyphs, grown to the
+ * largest image seen so far. A workspace must not be used by two threads at
+ * once.
+ */
+typedef struct distance_field_workspace_t
+{
+    /**
+     * Number of pixels the buffers can hold
+     */
+    size_t capacity;
+
+    /**
+     * Gradients and one sided distances of the current image
+     */
+    float *gx, *gy, *outside, *inside;
+
+    /**
+     * Offsets to the closest edge pixel of the current image
+     */
+    short *xdist, *ydist;
+
+    /**
+     * Image converted to the [0,1] range, when given as bytes
+     */
+    float *data;
+
+    /**
+     * Number of floats the scratch buffer can hold
+     */
+    size_t scratch_size;
+
+    /**
+     * Scratch space of the transforms, sized by edtaa3f_scratch
+     */
+    float *scratch;
+
+    /**
+     * Transform used by make_distance_mapf, DISTANCE_FIELD_EDTAA3 by default
+     */
+    distance_field_method_t method;
+
+    /**
+     * Distance in pixels mapped to 0 and 1 by make_distance_mapf, farther
+     * ones being clamped and not computed, so that fields of any size or
+     * font share the same scale. 0 (default) maps the largest distance of
+     * each image instead.
+     */
+    float spread;
+
+    /**
+     * Segments of the current outline, left for callers of
+     * make_distance_map_outline to fill
+     */
+    vector_t *segments;
+
+    /**
+     * Monotonic quadratic curves of the current outline and grid of the
+     * curves crossing each cell
+     */
+    vector_t *curves, *grid;
+
+} distance_field_workspace_t;
+
+
+/**
+ * Creates a new distance field workspace.
+ *
+ * @param capacity  number of pixels to allocate buffers for, 0 to allocate
+ *                  them with the first image
+ * @return          a new workspace
+ */
+distance_field_workspace_t *
+distance_field_workspace_new( size_t capacity );
+
+
+/**
+ * Deletes a distance field workspace.
+ *
+ * @param self  a workspace
+ */
+void
+distance_field_workspace_delete( distance_field_workspace_t *self );
+
+
+/**
+ * Grows the buffers of a workspace to hold at least capacity pixels.
+ *
+ * @param self      a workspace
+ * @param capacity  number of pixels
+ */
+void
+distance_field_workspace_reserve( distance_field_workspace_t *self,
+                                  size_t capacity );
+
+
+/**
+ * Computes the distance field of an image in single precision, without
+ * allocating once the workspace is large enough.
+ *
+ * @param data       a greyscale image in the [0,1] range, replaced by its
+ *                   distance field
+ * @param width      the width of the given image
+ * @param height     the height of the given image
+ * @param workspace  scratch buffers, grown as needed
+ *
+ * @return           data
+ */
+float *
+make_distance_mapf( float *data,
+                    unsigned int width, unsigned int height,
+                    distance_field_workspace_t *workspace );
+
+
+/**
+ * Computes the distance field of a byte image like make_distance_mapb, in
+ * single precision and into a caller provided buffer.
+ *
+ * @param img        a greyscale image
+ * @param out        destination of width x height bytes, may be img
+ * @param width      the width of the given image
+ * @param height     the height of the given image
+ * @param workspace  scratch buffers, grown as needed
+ */
+void
+make_distance_mapb_workspace( const unsigned char *img, unsigned char *out,
+                              unsigned int width, unsigned int height,
+                              distance_field_workspace_t *workspace );
+
+
+/**
+ * Computes the distance field of an outline from its segments rather than
+ * from a bitmap, as make_distance_mapb_workspace would from its coverage.
+ * Cubic curves are approximated by quadratic ones within a hundredth of a
+ * pixel. With a spread, each cell of the grid lists the curves closer than
+ * the spread to it, so that a pixel measures no other curve and pixels
+ * farther than the spread from the outline measure none.
+ *
+ * @param segments   closed contours of the outline
+ * @param count      number of segments
+ * @param even_odd   whether the outline is filled with the even-odd rule
+ *                   rather than the nonzero winding one
+ * @param out        destination of width x height bytes
+ * @param width      the width of the field
+ * @param height     the height of the field
+ * @param workspace  scratch buffers, grown as needed
+ */
+void
+make_distance_map_outline( const distance_field_segment_t *segments,
+                           size_t count, int even_odd, unsigned char *out,
+                           unsigned int width, unsigned int height,
+                           distance_field_workspace_t *workspace );
+
+
 /**
  * Create a distance file from the given image.
  *
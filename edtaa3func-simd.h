@@ -0,0 +1,372 @@
+/*
+ Copyright (C) 2009-2012 Stefan Gustavson (stefan.gustavson@gmail.com)
+ The code in this file is distributed under the MIT license:
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+/*
+ * Vectorized kernels of the single precision distance transform, included
+ * by edtaa3func.c once per instruction set with one of EDTAA3_ISA_SSE2,
+ * EDTAA3_ISA_AVX2 or EDTAA3_ISA_NEON defined. Every kernel does the same
+ * floating point operations in the same order as its scalar counterpart in
+ * edtaa3func.c, lane by lane, and hands the last pixels of a span over to
+ * it, so results are identical whichever kernels run.
+ */
+
+#if defined(EDTAA3_ISA_SSE2)
+
+#define EDTAA3_HAS_SSE2
+#define EDTAA3_ISA EDTAA3_SSE2
+#define KERNEL(name) name##_sse2
+#define KERNEL_ATTR
+#define LANES 4
+#define VF __m128
+#define VI __m128i
+#define VM __m128
+#define VF_LOAD(p)        _mm_loadu_ps(p)
+#define VF_STORE(p,v)     _mm_storeu_ps(p,v)
+#define VF_SET1(x)        _mm_set1_ps(x)
+#define VF_ADD(a,b)       _mm_add_ps(a,b)
+#define VF_SUB(a,b)       _mm_sub_ps(a,b)
+#define VF_MUL(a,b)       _mm_mul_ps(a,b)
+#define VF_DIV(a,b)       _mm_div_ps(a,b)
+#define VF_SQRT(a)        _mm_sqrt_ps(a)
+#define VF_MIN(a,b)       _mm_min_ps(a,b)
+#define VF_MAX(a,b)       _mm_max_ps(a,b)
+#define VF_LT(a,b)        _mm_cmplt_ps(a,b)
+#define VF_GT(a,b)        _mm_cmpgt_ps(a,b)
+#define VF_EQ(a,b)        _mm_cmpeq_ps(a,b)
+#define VF_SELECT(m,a,b)  _mm_or_ps(_mm_and_ps(m,a), _mm_andnot_ps(m,b))
+#define VM_AND(a,b)       _mm_and_ps(a,b)
+#define VM_OR(a,b)        _mm_or_ps(a,b)
+#define VM_ANY(m)         _mm_movemask_ps(m)
+#define VI_SET1(x)        _mm_set1_epi32(x)
+#define VI_SUB(a,b)       _mm_sub_epi32(a,b)
+#define VI_TOF(a)         _mm_cvtepi32_ps(a)
+
+static VI KERNEL(load16)(const short *p)
+{
+  __m128i x = _mm_loadl_epi64((const __m128i *)p);
+  return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+
+static void KERNEL(store8)(unsigned char *p, VI v)
+{
+  __m128i x = _mm_packs_epi32(v, v);
+  int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(x, x));
+  memcpy(p, &bytes, 4);
+}
+
+#define VF_TOI(a)         _mm_cvttps_epi32(a)
+
+#elif defined(EDTAA3_ISA_AVX2)
+
+#define EDTAA3_HAS_AVX2
+#define EDTAA3_ISA EDTAA3_AVX2
+#define KERNEL(name) name##_avx2
+#if defined(__GNUC__)
+#  define KERNEL_ATTR __attribute__((target("avx2")))
+#else
+#  define KERNEL_ATTR
+#endif
+#define LANES 8
+#define VF __m256
+#define VI __m256i
+#define VM __m256
+#define VF_LOAD(p)        _mm256_loadu_ps(p)
+#define VF_STORE(p,v)     _mm256_storeu_ps(p,v)
+#define VF_SET1(x)        _mm256_set1_ps(x)
+#define VF_ADD(a,b)       _mm256_add_ps(a,b)
+#define VF_SUB(a,b)       _mm256_sub_ps(a,b)
+#define VF_MUL(a,b)       _mm256_mul_ps(a,b)
+#define VF_DIV(a,b)       _mm256_div_ps(a,b)
+#define VF_SQRT(a)        _mm256_sqrt_ps(a)
+#define VF_MIN(a,b)       _mm256_min_ps(a,b)
+#define VF_MAX(a,b)       _mm256_max_ps(a,b)
+#define VF_LT(a,b)        _mm256_cmp_ps(a,b,_CMP_LT_OQ)
+#define VF_GT(a,b)        _mm256_cmp_ps(a,b,_CMP_GT_OQ)
+#define VF_EQ(a,b)        _mm256_cmp_ps(a,b,_CMP_EQ_OQ)
+#define VF_SELECT(m,a,b)  _mm256_blendv_ps(b,a,m)
+#define VM_AND(a,b)       _mm256_and_ps(a,b)
+#define VM_OR(a,b)        _mm256_or_ps(a,b)
+#define VM_ANY(m)         _mm256_movemask_ps(m)
+#define VI_SET1(x)        _mm256_set1_epi32(x)
+#define VI_SUB(a,b)       _mm256_sub_epi32(a,b)
+#define VI_TOF(a)         _mm256_cvtepi32_ps(a)
+#define VF_TOI(a)         _mm256_cvttps_epi32(a)
+
+static KERNEL_ATTR VI KERNEL(load16)(const short *p)
+{
+  return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p));
+}
+
+static KERNEL_ATTR void KERNEL(store8)(unsigned char *p, VI v)
+{
+  __m128i x = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  _mm_storel_epi64((__m128i *)p, _mm_packus_epi16(x, x));
+}
+
+#elif defined(EDTAA3_ISA_NEON)
+
+#define EDTAA3_HAS_NEON
+#define EDTAA3_ISA EDTAA3_NEON
+#define KERNEL(name) name##_neon
+#define KERNEL_ATTR
+#define LANES 4
+#define VF float32x4_t
+#define VI int32x4_t
+#define VM uint32x4_t
+#define VF_LOAD(p)        vld1q_f32(p)
+#define VF_STORE(p,v)     vst1q_f32(p,v)
+#define VF_SET1(x)        vdupq_n_f32(x)
+#define VF_ADD(a,b)       vaddq_f32(a,b)
+#define VF_SUB(a,b)       vsubq_f32(a,b)
+#define VF_MUL(a,b)       vmulq_f32(a,b)
+#define VF_DIV(a,b)       vdivq_f32(a,b)
+#define VF_SQRT(a)        vsqrtq_f32(a)
+#define VF_MIN(a,b)       vminq_f32(a,b)
+#define VF_MAX(a,b)       vmaxq_f32(a,b)
+#define VF_LT(a,b)        vcltq_f32(a,b)
+#define VF_GT(a,b)        vcgtq_f32(a,b)
+#define VF_EQ(a,b)        vceqq_f32(a,b)
+#define VF_SELECT(m,a,b)  vbslq_f32(m,a,b)
+#define VM_AND(a,b)       vandq_u32(a,b)
+#define VM_OR(a,b)        vorrq_u32(a,b)
+#define VM_ANY(m)         (vmaxvq_u32(m) != 0)
+#define VI_SET1(x)        vdupq_n_s32(x)
+#define VI_SUB(a,b)       vsubq_s32(a,b)
+#define VI_TOF(a)         vcvtq_f32_s32(a)
+#define VF_TOI(a)         vcvtq_s32_f32(a)
+
+static VI KERNEL(load16)(const short *p)
+{
+  return vmovl_s16(vld1_s16(p));
+}
+
+static void KERNEL(store8)(unsigned char *p, VI v)
+{
+  int16x4_t x = vmovn_s32(v);
+  uint8x8_t bytes = vqmovun_s16(vcombine_s16(x, x));
+  vst1_lane_u32((uint32_t *)p, vreinterpret_u32_u8(bytes), 0);
+}
+
+#endif
+
+#define VF_NEG(a) VF_SUB(VF_SET1(-0.0f), a)
+#define VF_ABS(a) VF_MAX(a, VF_NEG(a))
+
+static KERNEL_ATTR void KERNEL(computegradientf_span)(const float *img, int w, int k, int n, float *gx, float *gy)
+{
+  VF zero = VF_SET1(0.0f), one = VF_SET1(1.0f), s2 = VF_SET1(SQRT2F);
+  VF c, x, y, glength;
+  VM edge, nonzero;
+
+  for(; n >= LANES; k += LANES, n -= LANES) {
+    c = VF_LOAD(img+k);
+    edge = VM_AND(VF_GT(c, zero), VF_LT(c, one));
+    if(!VM_ANY(edge))
+      continue;
+    x = VF_SUB(VF_NEG(VF_LOAD(img+k-w-1)), VF_MUL(s2, VF_LOAD(img+k-1)));
+    x = VF_ADD(VF_SUB(x, VF_LOAD(img+k+w-1)), VF_LOAD(img+k-w+1));
+    x = VF_ADD(VF_ADD(x, VF_MUL(s2, VF_LOAD(img+k+1))), VF_LOAD(img+k+w+1));
+    y = VF_SUB(VF_NEG(VF_LOAD(img+k-w-1)), VF_MUL(s2, VF_LOAD(img+k-w)));
+    y = VF_ADD(VF_SUB(y, VF_LOAD(img+k-w+1)), VF_LOAD(img+k+w-1));
+    y = VF_ADD(VF_ADD(y, VF_MUL(s2, VF_LOAD(img+k+w))), VF_LOAD(img+k+w+1));
+    glength = VF_ADD(VF_MUL(x, x), VF_MUL(y, y));
+    nonzero = VF_GT(glength, zero);
+    glength = VF_SQRT(glength);
+    x = VF_SELECT(nonzero, VF_DIV(x, glength), x);
+    y = VF_SELECT(nonzero, VF_DIV(y, glength), y);
+    VF_STORE(gx+k, VF_SELECT(edge, x, VF_LOAD(gx+k)));
+    VF_STORE(gy+k, VF_SELECT(edge, y, VF_LOAD(gy+k)));
+  }
+  computegradientf_span(img, w, k, n, gx, gy);
+}
+
+/* distaa3f() for LANES pixels, the edge pixels being handled separately */
+static KERNEL_ATTR void KERNEL(edtaa3f_candidates_span)(const float *img, const float *gx, const float *gy, int w,
+                                                        const short *distx, const short *disty, const float *dist,
+                                                        int i, int n, int ox, int oy, float *cand)
+{
+  VF zero = VF_SET1(0.0f), one = VF_SET1(1.0f), half = VF_SET1(0.5f);
+  VF far = VF_SET1(FLT_MAX);
+  VF olddist, bound, nx, ny, a, dx, dy, di, a1, df1, df2, df3, newdist;
+  VM active, axis;
+  float values[LANES];
+  int c, l, p;
+
+  for(; n >= LANES; i += LANES, n -= LANES, cand += LANES) {
+    c = i + oy*w + ox;
+    olddist = VF_LOAD(dist+i);
+    nx = VI_TOF(VI_SUB(KERNEL(load16)(distx+c), VI_SET1(ox)));
+    ny = VI_TOF(VI_SUB(KERNEL(load16)(disty+c), VI_SET1(oy)));
+    bound = VF_ADD(olddist, VF_SET1(0.7072f));
+    active = VM_AND(VF_GT(olddist, zero),
+                    VF_LT(VF_ADD(VF_MUL(nx, nx), VF_MUL(ny, ny)), VF_MUL(bound, bound)));
+    if(!VM_ANY(active)) {
+      VF_STORE(cand, far);
+      continue;
+    }
+
+    /* Grayscale value at the edge pixels, clipped to [0,1] */
+    for(l = 0; l < LANES; l++) {
+      p = c + l;
+      values[l] = img[p - distx[p] - disty[p]*w];
+    }
+    a = VF_MIN(VF_MAX(VF_LOAD(values), zero), one);
+    if(!VM_ANY(VM_AND(active, VF_GT(a, zero)))) { // Only pixels with no edge yet
+      VF_STORE(cand, far);
+      continue;
+    }
+
+    /* Off axis, estimated from the direction to the edge */
+    dx = VF_ABS(nx);
+    dy = VF_ABS(ny);
+    a1 = VF_MIN(dx, dy);
+    dx = VF_MAX(dx, dy);
+    dy = a1;
+    di = VF_SQRT(VF_ADD(VF_MUL(dx, dx), VF_MUL(dy, dy)));
+    a1 = VF_DIV(VF_MUL(half, dy), dx);
+    df1 = VF_DIV(VF_SUB(VF_MUL(half, VF_ADD(dx, dy)),
+                        VF_SQRT(VF_MUL(VF_MUL(VF_MUL(VF_SET1(2.0f), dx), dy), a))), di);
+    df2 = VF_DIV(VF_MUL(VF_SUB(half, a), dx), di);
+    df3 = VF_DIV(VF_ADD(VF_MUL(VF_SET1(-0.5f), VF_ADD(dx, dy)),
+                        VF_SQRT(VF_MUL(VF_MUL(VF_MUL(VF_SET1(2.0f), dx), dy), VF_SUB(one, a)))), di);
+    newdist = VF_ADD(di, VF_SELECT(VF_LT(a, a1), df1,
+                                   VF_SELECT(VF_LT(a, VF_SUB(one, a1)), df2, df3)));
+
+    /* Axis aligned */
+    axis = VM_OR(VF_EQ(nx, zero), VF_EQ(ny, zero));
+    newdist = VF_SELECT(axis, VF_SUB(VF_ADD(VF_ABS(VF_ADD(nx, ny)), half), a), newdist);
+
+    /* Not an object pixel */
+    newdist = VF_SELECT(VF_EQ(a, zero), VF_SET1(1000000.0f), newdist);
+
+    /* At the edge, estimated from the local gradient */
+    if(VM_ANY(VM_AND(VF_EQ(nx, zero), VF_EQ(ny, zero)))) {
+      VF_STORE(values, newdist);
+      for(l = 0; l < LANES; l++) {
+        p = c + l;
+        if(distx[p] == ox && disty[p] == oy)
+          values[l] = distaa3f(img, gx, gy, w, p, distx[p], disty[p], 0, 0);
+      }
+      newdist = VF_LOAD(values);
+    }
+
+    VF_STORE(cand, VF_SELECT(active, newdist, far));
+  }
+  edtaa3f_candidates_span(img, gx, gy, w, distx, disty, dist, i, n, ox, oy, cand);
+}
+
+static KERNEL_ATTR void KERNEL(edtaa3f_clamp_span)(float *dist, int n)
+{
+  VF zero = VF_SET1(0.0f), v;
+
+  for(; n >= LANES; dist += LANES, n -= LANES) {
+    v = VF_LOAD(dist);
+    VF_STORE(dist, VF_SELECT(VF_LT(v, zero), zero, v));
+  }
+  edtaa3f_clamp_span(dist, n);
+}
+
+static KERNEL_ATTR void KERNEL(edtaa3f_invert_span)(float *img, int n)
+{
+  VF one = VF_SET1(1.0f);
+
+  for(; n >= LANES; img += LANES, n -= LANES)
+    VF_STORE(img, VF_SUB(one, VF_LOAD(img)));
+  edtaa3f_invert_span(img, n);
+}
+
+static KERNEL_ATTR float KERNEL(edtaa3f_subtract_span)(float *dist, const float *other, int n, float vmin)
+{
+  VF v, lowest = VF_SET1(vmin);
+  float values[LANES];
+  int l;
+
+  for(; n >= LANES; dist += LANES, other += LANES, n -= LANES) {
+    v = VF_SUB(VF_LOAD(dist), VF_LOAD(other));
+    VF_STORE(dist, v);
+    lowest = VF_SELECT(VF_LT(v, lowest), v, lowest);
+  }
+  VF_STORE(values, lowest);
+  for(l = 0; l < LANES; l++)
+    if(values[l] < vmin)
+      vmin = values[l];
+  return edtaa3f_subtract_span(dist, other, n, vmin);
+}
+
+static KERNEL_ATTR void KERNEL(edtaa3f_normalize_span)(const float *dist, float *img, int n, float vmin)
+{
+  VF low = VF_SET1(-vmin), high = VF_SET1(vmin), range = VF_SET1(2*vmin), v;
+
+  for(; n >= LANES; dist += LANES, img += LANES, n -= LANES) {
+    v = VF_LOAD(dist);
+    v = VF_SELECT(VF_LT(v, low), low, VF_SELECT(VF_GT(v, high), high, v));
+    VF_STORE(img, VF_DIV(VF_ADD(v, high), range));
+  }
+  edtaa3f_normalize_span(dist, img, n, vmin);
+}
+
+static KERNEL_ATTR void KERNEL(edtaa3f_bytes_span)(const float *img, unsigned char *out, int n)
+{
+  VF one = VF_SET1(1.0f), scale = VF_SET1(255.0f);
+
+  for(; n >= LANES; img += LANES, out += LANES, n -= LANES)
+    KERNEL(store8)(out, VF_TOI(VF_MUL(scale, VF_SUB(one, VF_LOAD(img)))));
+  edtaa3f_bytes_span(img, out, n);
+}
+
+static const edtaa3f_kernels_t KERNEL(edtaa3f) = {
+  EDTAA3_ISA, KERNEL(computegradientf_span), KERNEL(edtaa3f_candidates_span),
+  KERNEL(edtaa3f_clamp_span), KERNEL(edtaa3f_invert_span), KERNEL(edtaa3f_subtract_span),
+  KERNEL(edtaa3f_normalize_span), KERNEL(edtaa3f_bytes_span)
+};
+
+#undef EDTAA3_ISA
+#undef KERNEL
+#undef KERNEL_ATTR
+#undef LANES
+#undef VF
+#undef VI
+#undef VM
+#undef VF_LOAD
+#undef VF_STORE
+#undef VF_SET1
+#undef VF_ADD
+#undef VF_SUB
+#undef VF_MUL
+#undef VF_DIV
+#undef VF_SQRT
+#undef VF_MIN
+#undef VF_MAX
+#undef VF_LT
+#undef VF_GT
+#undef VF_EQ
+#undef VF_SELECT
+#undef VF_TOI
+#undef VF_NEG
+#undef VF_ABS
+#undef VM_AND
+#undef VM_OR
+#undef VM_ANY
+#undef VI_SET1
+#undef VI_SUB
+#undef VI_TOF
@@ -54,6 +54,17 @@
  THE SOFTWARE.
  */
 
+#include <float.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef FREETYPE_GL_USE_THREADS
+#  if defined(_WIN32) || defined(_WIN64)
+#    include <windows.h>
+#  else
+#    include <pthread.h>
+#  endif
+#endif
 #include "edtaa3func.h"
 
 /*
@@ -573,3 +584,650 @@ void edtaa3(double *img, double *gx, double *gy, int w, int h, short *distx, sho
   /* The transformation is completed. */
 
 }
+
+/*
+ * Single precision versions of the functions above, computing the same
+ * transform with half the memory traffic. Before each row is scanned, the
+ * distances through its neighbours on the previous row are computed for the
+ * whole row, which is independent from pixel to pixel and runs in vector
+ * registers when the CPU allows; the scan then tests them in the same order
+ * as edtaa3(). The scalar kernels below are the reference the vectorized
+ * ones in edtaa3func-simd.h match exactly.
+ */
+#define SQRT2F 1.4142136f
+
+static void computegradientf_span(const float *img, int w, int k, int n, float *gx, float *gy)
+{
+    float glength;
+
+    for(; n > 0; k++, n--) {
+        if((img[k]>0.0f) && (img[k]<1.0f)) { // Compute gradient for edge pixels only
+            gx[k] = -img[k-w-1] - SQRT2F*img[k-1] - img[k+w-1] + img[k-w+1] + SQRT2F*img[k+1] + img[k+w+1];
+            gy[k] = -img[k-w-1] - SQRT2F*img[k-w] - img[k-w+1] + img[k+w-1] + SQRT2F*img[k+w] + img[k+w+1];
+            glength = gx[k]*gx[k] + gy[k]*gy[k];
+            if(glength > 0.0f) { // Avoid division by zero
+                glength = sqrtf(glength);
+                gx[k]=gx[k]/glength;
+                gy[k]=gy[k]/glength;
+            }
+        }
+    }
+}
+
+float edgedff(float gx, float gy, float a)
+{
+    float df, glength, temp, a1;
+
+    if ((gx == 0) || (gy == 0)) { // Either A) gu or gv are zero, or B) both
+        df = 0.5f-a;  // Linear approximation is A) correct or B) a fair guess
+    } else {
+        glength = sqrtf(gx*gx + gy*gy);
+        if(glength>0) {
+            gx = gx/glength;
+            gy = gy/glength;
+        }
+        /* Move to first octant (gx>=0, gy>=0, gx>=gy) as in edgedf() */
+        gx = fabsf(gx);
+        gy = fabsf(gy);
+        if(gx<gy) {
+            temp = gx;
+            gx = gy;
+            gy = temp;
+        }
+        a1 = 0.5f*gy/gx;
+        if (a < a1) { // 0 <= a < a1
+            df = 0.5f*(gx + gy) - sqrtf(2.0f*gx*gy*a);
+        } else if (a < (1.0f-a1)) { // a1 <= a <= 1-a1
+            df = (0.5f-a)*gx;
+        } else { // 1-a1 < a <= 1
+            df = -0.5f*(gx + gy) + sqrtf(2.0f*gx*gy*(1.0f-a));
+        }
+    }
+    return df;
+}
+
+float distaa3f(const float *img, const float *gximg, const float *gyimg, int w, int c, int xc, int yc, int xi, int yi)
+{
+  float di, df, dx, dy, a, a1;
+  int closest;
+
+  closest = c-xc-yc*w; // Index to the edge pixel pointed to from c
+  a = img[closest];    // Grayscale value at the edge pixel
+
+  if(a > 1.0f) a = 1.0f;
+  if(a < 0.0f) a = 0.0f; // Clip grayscale values outside the range [0,1]
+  if(a == 0.0f) return 1000000.0f; // Not an object pixel, return "very far" ("don't know yet")
+
+  if(xi==0 && yi==0) // Use local gradient only at edges
+      return edgedff(gximg[closest], gyimg[closest], a);
+  if(xi==0 || yi==0) // Axis aligned, as edgedff() would find
+      return (float)abs(xi+yi) + 0.5f - a;
+
+  /* Estimate gradient based on direction to edge (accurate for large di),
+   * which edgedff() would normalize and move to the first octant */
+  dx = (float)abs(xi);
+  dy = (float)abs(yi);
+  if(dx<dy) {
+      a1 = dx;
+      dx = dy;
+      dy = a1;
+  }
+  di = sqrtf(dx*dx + dy*dy); // Length of integer vector, like a traditional EDT
+  a1 = 0.5f*dy/dx;
+  if (a < a1) { // 0 <= a < a1
+      df = (0.5f*(dx + dy) - sqrtf(2.0f*dx*dy*a))/di;
+  } else if (a < (1.0f-a1)) { // a1 <= a <= 1-a1
+      df = (0.5f-a)*dx/di;
+  } else { // 1-a1 < a <= 1
+      df = (-0.5f*(dx + dy) + sqrtf(2.0f*dx*dy*(1.0f-a)))/di;
+  }
+  return di + df;
+}
+
+/*
+ * Tests whether pixel i is closer to the edge pixel its neighbour at (ox,oy)
+ * points to than to its own, and points it there if so. The edge distance
+ * correction of distaa3f() is at most 0.5*sqrt(2), so candidates whose
+ * integer distance alone is too large are rejected without computing it.
+ */
+static int edtaa3f_relax(const float *img, const float *gx, const float *gy, int w,
+                         short *distx, short *disty, float *dist, int i, int ox, int oy)
+{
+  int c = i + oy*w + ox;
+  int newdistx = distx[c]-ox;
+  int newdisty = disty[c]-oy;
+  float olddist = dist[i];
+  float bound = olddist + 0.7072f;
+  float newdist;
+
+  if((float)(newdistx*newdistx + newdisty*newdisty) >= bound*bound)
+    return 0;
+  newdist = distaa3f(img, gx, gy, w, c, distx[c], disty[c], newdistx, newdisty);
+  if(newdist < olddist-1e-3f)
+    {
+      distx[i] = newdistx;
+      disty[i] = newdisty;
+      dist[i] = newdist;
+      return 1;
+    }
+  return 0;
+}
+
+/*
+ * Distances through the neighbour at (ox,oy) on the previous row of the n
+ * pixels from i on, stored in cand from 0 on. That row does not change
+ * while the current one is scanned, so these can be computed before
+ * edtaa3f_accept() tests them in order. Candidates edtaa3f_relax() would
+ * reject without computing them are FLT_MAX.
+ */
+static void edtaa3f_candidates_span(const float *img, const float *gx, const float *gy, int w,
+                                    const short *distx, const short *disty, const float *dist,
+                                    int i, int n, int ox, int oy, float *cand)
+{
+  int c, newdistx, newdisty;
+  float bound;
+
+  for(; n > 0; i++, n--, cand++) {
+    c = i + oy*w + ox;
+    newdistx = distx[c]-ox;
+    newdisty = disty[c]-oy;
+    bound = dist[i] + 0.7072f;
+    if(dist[i] > 0 && (float)(newdistx*newdistx + newdisty*newdisty) < bound*bound)
+      *cand = distaa3f(img, gx, gy, w, c, distx[c], disty[c], newdistx, newdisty);
+    else
+      *cand = FLT_MAX;
+  }
+}
+
+/* edtaa3f_relax() for a candidate computed by edtaa3f_candidates_span() */
+static int edtaa3f_accept(int w, short *distx, short *disty, float *dist, int i, int ox, int oy, float newdist)
+{
+  int c = i + oy*w + ox;
+
+  if(newdist < dist[i]-1e-3f)
+    {
+      distx[i] = distx[c]-ox;
+      disty[i] = disty[c]-oy;
+      dist[i] = newdist;
+      return 1;
+    }
+  return 0;
+}
+
+static void edtaa3f_clamp_span(float *dist, int n)
+{
+  for(; n > 0; dist++, n--)
+    if(*dist < 0.0f)
+      *dist = 0.0f;
+}
+
+static void edtaa3f_invert_span(float *img, int n)
+{
+  for(; n > 0; img++, n--)
+    *img = 1 - *img;
+}
+
+static float edtaa3f_subtract_span(float *dist, const float *other, int n, float vmin)
+{
+  for(; n > 0; dist++, other++, n--)
+    {
+      *dist -= *other;
+      if(*dist < vmin)
+        vmin = *dist;
+    }
+  return vmin;
+}
+
+static void edtaa3f_normalize_span(const float *dist, float *img, int n, float vmin)
+{
+  float v;
+
+  for(; n > 0; dist++, img++, n--)
+    {
+      v = *dist;
+      if     ( v < -vmin) v = -vmin;
+      else if( v > +vmin) v = +vmin;
+      *img = (v+vmin)/(2*vmin);
+    }
+}
+
+static void edtaa3f_bytes_span(const float *img, unsigned char *out, int n)
+{
+  for(; n > 0; img++, out++, n--)
+    *out = (unsigned char)(255*(1-*img));
+}
+
+/* Kernels of one instruction set */
+typedef struct edtaa3f_kernels_t
+{
+  int isa;
+  void (*gradient)(const float *img, int w, int k, int n, float *gx, float *gy);
+  void (*candidates)(const float *img, const float *gx, const float *gy, int w,
+                     const short *distx, const short *disty, const float *dist,
+                     int i, int n, int ox, int oy, float *cand);
+  void (*clamp)(float *dist, int n);
+  void (*invert)(float *img, int n);
+  float (*subtract)(float *dist, const float *other, int n, float vmin);
+  void (*normalize)(const float *dist, float *img, int n, float vmin);
+  void (*bytes)(const float *img, unsigned char *out, int n);
+} edtaa3f_kernels_t;
+
+static const edtaa3f_kernels_t edtaa3f_scalar = {
+  EDTAA3_SCALAR, computegradientf_span, edtaa3f_candidates_span, edtaa3f_clamp_span,
+  edtaa3f_invert_span, edtaa3f_subtract_span, edtaa3f_normalize_span, edtaa3f_bytes_span
+};
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define EDTAA3_ISA_SSE2
+#  include "edtaa3func-simd.h"
+#  undef EDTAA3_ISA_SSE2
+#  if (defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))) || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#    include <immintrin.h>
+#    define EDTAA3_ISA_AVX2
+#    include "edtaa3func-simd.h"
+#    undef EDTAA3_ISA_AVX2
+#    if defined(_MSC_VER) && !defined(__clang__)
+#      include <intrin.h>
+#    endif
+#  endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#  include <arm_neon.h>
+#  define EDTAA3_ISA_NEON
+#  include "edtaa3func-simd.h"
+#  undef EDTAA3_ISA_NEON
+#endif
+
+static const edtaa3f_kernels_t *edtaa3f_kernels = 0;
+
+/* Whether the CPU and the operating system support AVX2 */
+static int edtaa3f_has_avx2(void)
+{
+#if defined(EDTAA3_HAS_AVX2) && defined(__GNUC__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#elif defined(EDTAA3_HAS_AVX2) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  if(!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6) // OSXSAVE, XMM and YMM state
+    return 0;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return 0;
+#endif
+}
+
+int edtaa3f_simd(int isa)
+{
+  const edtaa3f_kernels_t *kernels = &edtaa3f_scalar;
+
+#if defined(EDTAA3_HAS_SSE2)
+  if(isa < 0 || isa >= EDTAA3_SSE2)
+    kernels = &edtaa3f_sse2;
+#endif
+#if defined(EDTAA3_HAS_AVX2)
+  if((isa < 0 || isa >= EDTAA3_AVX2) && edtaa3f_has_avx2())
+    kernels = &edtaa3f_avx2;
+#endif
+#if defined(EDTAA3_HAS_NEON)
+  if(isa < 0 || isa == EDTAA3_NEON)
+    kernels = &edtaa3f_neon;
+#endif
+  edtaa3f_kernels = kernels;
+  return kernels->isa;
+}
+
+/* Selects the best kernels unless edtaa3f_simd() selected others */
+static void edtaa3f_default_kernels(void)
+{
+  if(!edtaa3f_kernels)
+    edtaa3f_simd(-1);
+}
+
+#if defined(FREETYPE_GL_USE_THREADS) && (defined(_WIN32) || defined(_WIN64))
+static INIT_ONCE edtaa3f_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK edtaa3f_default_kernels_once(PINIT_ONCE once, PVOID parameter, PVOID *context)
+{
+  (void)once; (void)parameter; (void)context;
+  edtaa3f_default_kernels();
+  return TRUE;
+}
+#elif defined(FREETYPE_GL_USE_THREADS)
+static pthread_once_t edtaa3f_once = PTHREAD_ONCE_INIT;
+#endif
+
+/* Kernels to use, selected once even when transforms run on several threads */
+static const edtaa3f_kernels_t *edtaa3f_get_kernels(void)
+{
+#if defined(FREETYPE_GL_USE_THREADS) && (defined(_WIN32) || defined(_WIN64))
+  InitOnceExecuteOnce(&edtaa3f_once, edtaa3f_default_kernels_once, NULL, NULL);
+#elif defined(FREETYPE_GL_USE_THREADS)
+  pthread_once(&edtaa3f_once, edtaa3f_default_kernels);
+#else
+  edtaa3f_default_kernels();
+#endif
+  return edtaa3f_kernels;
+}
+
+void computegradientf(const float *img, int w, int h, float *gx, float *gy)
+{
+  const edtaa3f_kernels_t *kernels = edtaa3f_get_kernels();
+  int i;
+
+  for(i = 1; i < h-1; i++) // Avoid edges where the kernels would spill over
+    kernels->gradient(img, w, i*w + 1, w-2, gx, gy);
+}
+
+#define EDTAA3_TILE 8 // Side of the tiles skipped by the sweeps
+
+/*
+ * Marks the tiles of the image with pixels whose distance may be below limit:
+ * those within limit of a tile that, with a pixel around it, is neither all
+ * background nor all inside. Sweeps skip the others, whose pixels keep the
+ * distances they were initialized with. Returns the number of tiles per row.
+ */
+static int edtaa3f_tiles(const float *img, int w, int h, float limit, unsigned char *tiles)
+{
+  int tw = (w + EDTAA3_TILE-1)/EDTAA3_TILE, th = (h + EDTAA3_TILE-1)/EDTAA3_TILE;
+  int r, tx, ty, x, y, x0, x1, y0, y1, count;
+  float lo, hi;
+
+  r = tw + th; // Covers the image, and does not overflow with a large limit
+  if(limit < (float)(r*EDTAA3_TILE))
+    r = (int)(limit/EDTAA3_TILE) + 1;
+
+  /* Tiles with edges, in bit 1 */
+  for(ty=0; ty<th; ty++)
+    for(tx=0; tx<tw; tx++)
+      {
+        y0 = ty*EDTAA3_TILE > 0 ? ty*EDTAA3_TILE-1 : 0;
+        y1 = (ty+1)*EDTAA3_TILE < h ? (ty+1)*EDTAA3_TILE+1 : h;
+        x0 = tx*EDTAA3_TILE > 0 ? tx*EDTAA3_TILE-1 : 0;
+        x1 = (tx+1)*EDTAA3_TILE < w ? (tx+1)*EDTAA3_TILE+1 : w;
+        lo = 1.0f;
+        hi = 0.0f;
+        for(y=y0; y<y1; y++)
+          for(x=x0; x<x1; x++)
+            {
+              if(img[y*w+x] < lo) lo = img[y*w+x];
+              if(img[y*w+x] > hi) hi = img[y*w+x];
+            }
+        tiles[ty*tw+tx] = (hi > 0.0f && lo < 1.0f) ? 1 : 0;
+      }
+
+  /* Within r tiles of those along rows, in bit 2, then along columns, in
+   * bit 4, counting bits in a sliding window */
+  for(ty=0; ty<th; ty++)
+    {
+      unsigned char *row = tiles + ty*tw;
+      for(count=0, tx=0; tx<tw && tx<=r; tx++)
+        count += row[tx] & 1;
+      for(tx=0; tx<tw; tx++)
+        {
+          if(count)
+            row[tx] |= 2;
+          if(tx+r+1 < tw)
+            count += row[tx+r+1] & 1;
+          if(tx-r >= 0)
+            count -= row[tx-r] & 1;
+        }
+    }
+  for(tx=0; tx<tw; tx++)
+    {
+      for(count=0, ty=0; ty<th && ty<=r; ty++)
+        count += (tiles[ty*tw+tx] >> 1) & 1;
+      for(ty=0; ty<th; ty++)
+        {
+          if(count)
+            tiles[ty*tw+tx] |= 4;
+          if(ty+r+1 < th)
+            count += (tiles[(ty+r+1)*tw+tx] >> 1) & 1;
+          if(ty-r >= 0)
+            count -= (tiles[(ty-r)*tw+tx] >> 1) & 1;
+        }
+    }
+  return tw;
+}
+
+/* Next run of marked tiles on a row of tiles from column *x on, returning
+ * its first column and storing in *x the one past its end */
+static int edtaa3f_run(const unsigned char *row, int w, int *x)
+{
+  int x0, tx = *x/EDTAA3_TILE;
+
+  while(*x < w && !(row[tx] & 4)) {
+    tx++;
+    *x = tx*EDTAA3_TILE;
+  }
+  x0 = *x < w ? *x : w;
+  while(*x < w && (row[tx] & 4)) {
+    tx++;
+    *x = tx*EDTAA3_TILE;
+  }
+  if(*x > w)
+    *x = w;
+  return x0;
+}
+
+/* One forward and one backward sweep of edtaa3f() over the marked tiles,
+ * returning whether any distance changed */
+static int edtaa3f_sweep(const float *img, const float *gx, const float *gy, int w, int h, short *distx, short *disty, float *dist, float *cand, const unsigned char *tiles, int tw)
+{
+  const edtaa3f_kernels_t *kernels = edtaa3f_get_kernels();
+  const unsigned char *row;
+  float *lu = cand, *u = cand + w, *ur = cand + 2*w;
+  int x, x0, x1, y, i;
+  int changed = 0;
+
+  lu[0] = ur[w-1] = FLT_MAX; // No neighbours beyond the sides
+
+  /* Scan rows, except first row */
+  for(y=1; y<h; y++)
+    for(row = tiles + (y/EDTAA3_TILE)*tw, x1 = 0; (x0 = edtaa3f_run(row, w, &x1)) < w; )
+      {
+        /* distances from above */
+        i = y*w + x0;
+        if(x0 > 0)
+          kernels->candidates(img, gx, gy, w, distx, disty, dist, i, x1-x0, -1, -1, lu+x0);
+        else
+          kernels->candidates(img, gx, gy, w, distx, disty, dist, i+1, x1-1, -1, -1, lu+1);
+        kernels->candidates(img, gx, gy, w, distx, disty, dist, i, x1-x0, 0, -1, u+x0);
+        kernels->candidates(img, gx, gy, w, distx, disty, dist, i, (x1 < w ? x1 : w-1)-x0, 1, -1, ur+x0);
+
+        /* scan right, propagate distances from above & left */
+        for(x=x0; x<x1; x++, i++)
+          {
+            if(dist[i] <= 0) continue;
+            if(x > 0)
+              changed |= edtaa3f_relax(img, gx, gy, w, distx, disty, dist, i, -1, 0);
+            changed |= edtaa3f_accept(w, distx, disty, dist, i, -1, -1, lu[x]);
+            changed |= edtaa3f_accept(w, distx, disty, dist, i, 0, -1, u[x]);
+            changed |= edtaa3f_accept(w, distx, disty, dist, i, 1, -1, ur[x]);
+          }
+
+        /* scan left, propagate distance from right */
+        for(x=(x1 < w ? x1 : w-1)-1, i=y*w+x; x>=x0; x--, i--)
+          if(dist[i] > 0)
+            changed |= edtaa3f_relax(img, gx, gy, w, distx, disty, dist, i, 1, 0);
+      }
+
+  /* Scan rows in reverse order, except last row */
+  for(y=h-2; y>=0; y--)
+    for(row = tiles + (y/EDTAA3_TILE)*tw, x1 = 0; (x0 = edtaa3f_run(row, w, &x1)) < w; )
+      {
+        /* distances from below, ur and lu now holding those from below
+           right and below left */
+        i = y*w + x0;
+        kernels->candidates(img, gx, gy, w, distx, disty, dist, i, (x1 < w ? x1 : w-1)-x0, 1, 1, ur+x0);
+        kernels->candidates(img, gx, gy, w, distx, disty, dist, i, x1-x0, 0, 1, u+x0);
+        if(x0 > 0)
+          kernels->candidates(img, gx, gy, w, distx, disty, dist, i, x1-x0, -1, 1, lu+x0);
+        else
+          kernels->candidates(img, gx, gy, w, distx, disty, dist, i+1, x1-1, -1, 1, lu+1);
+
+        /* scan left, propagate distances from below & right */
+        for(x=x1-1, i=y*w+x; x>=x0; x--, i--)
+          {
+            if(dist[i] <= 0) continue;
+            if(x < w-1)
+              changed |= edtaa3f_relax(img, gx, gy, w, distx, disty, dist, i, 1, 0);
+            changed |= edtaa3f_accept(w, distx, disty, dist, i, 1, 1, ur[x]);
+            changed |= edtaa3f_accept(w, distx, disty, dist, i, 0, 1, u[x]);
+            changed |= edtaa3f_accept(w, distx, disty, dist, i, -1, 1, lu[x]);
+          }
+
+        /* scan right, propagate distance from left */
+        for(x=(x0 > 0 ? x0 : 1), i=y*w+x; x<x1; x++, i++)
+          if(dist[i] > 0)
+            changed |= edtaa3f_relax(img, gx, gy, w, distx, disty, dist, i, -1, 0);
+      }
+  return changed;
+}
+
+int edtaa3f_scratch(int w, int h)
+{
+  int tiles = ((w + EDTAA3_TILE-1)/EDTAA3_TILE) * ((h + EDTAA3_TILE-1)/EDTAA3_TILE);
+
+  return 4*w + 1 + (tiles + (int)sizeof(float)-1)/(int)sizeof(float);
+}
+
+void edtaa3f(const float *img, const float *gx, const float *gy, int w, int h, short *distx, short *disty, float *dist, float limit, float *scratch)
+{
+  unsigned char *tiles = (unsigned char *)(scratch + 4*w + 1);
+  int i, tw;
+
+  /* Initialize the distance images */
+  for(i=0; i<w*h; i++) {
+    distx[i] = 0; // At first, all pixels point to
+    disty[i] = 0; // themselves as the closest known.
+    if(img[i] <= 0.0f)
+      dist[i]= limit; // Means "not set yet", and prunes farther candidates
+    else if (img[i]<1.0f)
+      dist[i] = edgedff(gx[i], gy[i], img[i]); // Gradient-assisted estimate
+    else
+      dist[i]= 0.0f; // Inside the object
+  }
+
+  /* Perform the transformation, in the same order as edtaa3() */
+  tw = edtaa3f_tiles(img, w, h, limit, tiles);
+  while(edtaa3f_sweep(img, gx, gy, w, h, distx, disty, dist, scratch, tiles, tw))
+    ; // Sweep until no more updates are made
+}
+
+/*
+ * Exact Euclidean distance transform of Felzenszwalb and Huttenlocher, "Distance
+ * Transforms of Sampled Functions" (2012), finding the closest pixel with
+ * img > 0 for every pixel in two passes of O(w*h) each. Distances to that pixel
+ * are then corrected for anti-aliasing by distaa3f(), as in edtaa3f(), but
+ * with no further sweep.
+ */
+#define EDT_NONE SHRT_MAX // No object pixel in the column
+
+void edtexactf(const float *img, const float *gx, const float *gy, int w, int h, short *distx, short *disty, float *dist, float limit, float *scratch)
+{
+  float *f = scratch, *z = scratch + w; // Parabola heights and boundaries
+  int *v = (int *)(z + w + 1);          // Parabola vertices
+  int *dy = v + w;                      // Column offsets of the current row
+  unsigned char *tiles = (unsigned char *)(dy + w); // Tiles to sweep
+  float bound = (limit + 0.7072f)*(limit + 0.7072f);
+  float s;
+  int x, y, i, k, q;
+
+  /* Columns: offset to the closest object pixel above, then below */
+  for(i=0; i<w; i++)
+    disty[i] = img[i] > 0.0f ? 0 : EDT_NONE;
+  for(i=w; i<w*h; i++)
+    disty[i] = img[i] > 0.0f ? 0 : disty[i-w] == EDT_NONE ? EDT_NONE : disty[i-w]+1;
+  for(i=w*(h-1)-1; i>=0; i--)
+    if(disty[i+w] <= 0 && (disty[i] == EDT_NONE || 1-disty[i+w] < disty[i]))
+      disty[i] = disty[i+w]-1;
+
+  /* Rows: lower envelope of the parabolas (x-q)^2 + dy(q)^2 */
+  for(y=0; y<h; y++)
+    {
+      i = y*w;
+      k = -1;
+      for(q=0; q<w; q++)
+        {
+          dy[q] = disty[i+q];
+          if(dy[q] == EDT_NONE)
+            continue;
+          f[q] = (float)(dy[q]*dy[q] + q*q);
+          if(k < 0)
+            s = -FLT_MAX;
+          else
+            for(;;) { // z[0] being -FLT_MAX, k stays positive
+              s = (f[q] - f[v[k]]) / (float)(2*(q-v[k]));
+              if(s > z[k])
+                break;
+              k--;
+            }
+          k++;
+          v[k] = q;
+          z[k] = s;
+          z[k+1] = FLT_MAX;
+        }
+
+      if(k < 0) // No object pixel in the image
+        {
+          for(x=0; x<w; x++, i++)
+            {
+              distx[i] = disty[i] = 0;
+              dist[i] = limit;
+            }
+          continue;
+        }
+
+      /* Closest object pixel, the distance to its edge corrected by distaa3f() */
+      for(x=0, k=0; x<w; x++, i++)
+        {
+          if(img[i] >= 1.0f) {
+            distx[i] = disty[i] = 0;
+            dist[i] = 0.0f; // Inside the object
+            continue;
+          }
+          while(z[k+1] < (float)x)
+            k++;
+          distx[i] = x - v[k];
+          disty[i] = dy[v[k]];
+          if(img[i] > 0.0f)
+            dist[i] = edgedff(gx[i], gy[i], img[i]); // Gradient-assisted estimate
+          else if((float)(distx[i]*distx[i] + disty[i]*disty[i]) >= bound)
+            dist[i] = limit; // Beyond the limit whatever the correction
+          else
+            dist[i] = distaa3f(img, gx, gy, w, i, distx[i], disty[i], distx[i], disty[i]);
+        }
+    }
+
+  /* The closest pixel is not always the one whose edge is the closest:
+   * one sweep of edtaa3f() looks at those of the neighbours */
+  edtaa3f_sweep(img, gx, gy, w, h, distx, disty, dist, scratch, tiles,
+                edtaa3f_tiles(img, w, h, limit, tiles));
+}
+
+void edtaa3f_clamp(float *dist, int n)
+{
+  edtaa3f_get_kernels()->clamp(dist, n);
+}
+
+void edtaa3f_invert(float *img, int n)
+{
+  edtaa3f_get_kernels()->invert(img, n);
+}
+
+float edtaa3f_subtract(float *dist, const float *other, int n)
+{
+  return edtaa3f_get_kernels()->subtract(dist, other, n, FLT_MAX);
+}
+
+void edtaa3f_normalize(const float *dist, float *img, int n, float vmin)
+{
+  edtaa3f_get_kernels()->normalize(dist, img, n, vmin);
+}
+
+void edtaa3f_bytes(const float *img, unsigned char *out, int n)
+{
+  edtaa3f_get_kernels()->bytes(img, out, n);
+}
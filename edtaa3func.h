@@ -95,6 +95,68 @@ double distaa3(double *img, double *gximg, double *gyimg, int w, int c, int xc,
 
 void edtaa3(double *img, double *gx, double *gy, int w, int h, short *distx, short *disty, double *dist);
 
+/*
+ * Single precision versions of computegradient(), edgedf(), distaa3() and
+ * edtaa3(), giving the same transform within float rounding. The gradient,
+ * the propagation of distances from the previous row and the loops below
+ * run in SSE2, AVX2 or NEON vector registers when available, with the
+ * same results as the scalar code. edtaa3f() needs edtaa3f_scratch(w,h)
+ * floats of scratch. Distances are only computed up to limit, pixels any
+ * farther being given limit, and regions of the image that far from edges
+ * are skipped: 1000000 computes them all, as edtaa3() does.
+ */
+void computegradientf(const float *img, int w, int h, float *gx, float *gy);
+
+float edgedff(float gx, float gy, float a);
+
+float distaa3f(const float *img, const float *gximg, const float *gyimg, int w, int c, int xc, int yc, int xi, int yi);
+
+void edtaa3f(const float *img, const float *gx, const float *gy, int w, int h, short *distx, short *disty, float *dist, float limit, float *scratch);
+
+int edtaa3f_scratch(int w, int h);
+
+/*
+ * Alternative to edtaa3f() taking the same arguments, in a time linear in
+ * w*h whatever the image: the closest pixel with img > 0 is found exactly
+ * by the separable transform of Felzenszwalb and Huttenlocher, the distance
+ * to it is corrected by distaa3f(), and a single sweep of edtaa3f() then
+ * looks for closer edges through the neighbours.
+ */
+void edtexactf(const float *img, const float *gx, const float *gy, int w, int h, short *distx, short *disty, float *dist, float limit, float *scratch);
+
+/*
+ * Loops of a distance field computation: replace negative distances by 0,
+ * replace img by 1-img, subtract other from dist returning the smallest
+ * result, map dist from [-vmin,vmin] to img in [0,1], and store 255*(1-img)
+ * as bytes.
+ */
+void edtaa3f_clamp(float *dist, int n);
+
+void edtaa3f_invert(float *img, int n);
+
+float edtaa3f_subtract(float *dist, const float *other, int n);
+
+void edtaa3f_normalize(const float *dist, float *img, int n, float vmin);
+
+void edtaa3f_bytes(const float *img, unsigned char *out, int n);
+
+/* Instruction sets of the single precision functions */
+#define EDTAA3_SCALAR 0
+#define EDTAA3_SSE2   1
+#define EDTAA3_AVX2   2
+#define EDTAA3_NEON   3
+
+/*
+ * Selects the instruction set of the single precision functions, the best
+ * one this build and CPU support for -1 (the default) or up to isa, and
+ * returns the one selected. Scalar code is the reference the others match.
+ * Without a call, the best one is selected once on first use, which is safe
+ * from several threads. This function itself must not be called while
+ * transforms run on other threads, e.g. during texture_font_load_glyphs with
+ * worker threads.
+ */
+int edtaa3f_simd(int isa);
+
 
 #ifdef __cplusplus
 }
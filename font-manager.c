@@ -73,6 +73,7 @@ font_manager_new( size_t width, size_t height, size_t depth )
     self->atlas = atlas;
     self->fonts = vector_new( sizeof(texture_font_t *) );
     self->cache = strdup( " " );
+    self->max_pages = 1;
     return self;
 }
 
@@ -114,9 +115,8 @@ font_manager_delete_font( font_manager_t * self,
 
     for( i=0; i<self->fonts->size;++i )
     {
-        other = (texture_font_t *) vector_get( self->fonts, i );
-        if ( (strcmp(font->filename, other->filename) == 0)
-               && ( font->size == other->size) )
+        other = *(texture_font_t **) vector_get( self->fonts, i );
+        if ( other == font )
         {
             vector_erase( self->fonts, i);
             break;
@@ -127,6 +127,16 @@ font_manager_delete_font( font_manager_t * self,
 
 
 
+// --------------------------------------------------- font_manager_compact ---
+size_t
+font_manager_compact( font_manager_t * self )
+{
+    assert( self );
+
+    return texture_font_compact( self->atlas );
+}
+
+
 // ----------------------------------------- font_manager_get_from_filename ---
 texture_font_t *
 font_manager_get_from_filename( font_manager_t *self,
@@ -149,6 +159,7 @@ font_manager_get_from_filename( font_manager_t *self,
     if( font )
     {
         vector_push_back( self->fonts, &font );
+        font->max_pages = self->max_pages;
         texture_font_load_glyphs( font, self->cache );
         return font;
     }
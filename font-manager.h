@@ -91,6 +91,12 @@ typedef struct font_manager_t {
      */
     char * cache;
 
+    /**
+     * Maximum number of atlas pages given to new fonts (1 by default). Text
+     * buffers upload and draw every page themselves when above 1.
+     */
+    size_t max_pages;
+
 } font_manager_t;
 
 
@@ -134,6 +140,19 @@ typedef struct font_manager_t {
                             texture_font_t * font );
 
 
+/**
+ *  Repack the glyphs of all the fonts using the atlas of the manager,
+ *  including those created outside of it, into a fresh atlas layout,
+ *  reclaiming the regions of deleted fonts (see texture_font_compact). Text buffers using the manager must be rebuilt.
+ *  The repacking runs synchronously on the calling thread and must be called
+ *  outside frame-critical paths.
+ *  @param self a font manager.
+ *  @return area (in pixels) reclaimed from regions no glyph was using
+ */
+  size_t
+  font_manager_compact( font_manager_t * self );
+
+
 /**
  *  Request for a font based on a filename.
  *
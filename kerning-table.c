@@ -0,0 +1,734 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kerning-table.h"
+
+
+/* Pair being collected, order is the subtable the pair comes from */
+typedef struct kerning_entry_t
+{
+    uint32_t left;
+    uint32_t right;
+    int32_t value;
+    uint32_t order;
+} kerning_entry_t;
+
+/* Raw table data */
+typedef struct kerning_data_t
+{
+    FT_Byte *bytes;
+    FT_ULong length;
+} kerning_data_t;
+
+#define KERN_FEATURE  FT_MAKE_TAG( 'k', 'e', 'r', 'n' )
+
+
+// ------------------------------------------------------- kerning_data_has ---
+static int
+kerning_data_has( const kerning_data_t *data, FT_ULong offset, FT_ULong size )
+{
+    return offset <= data->length && size <= data->length - offset;
+}
+
+// ------------------------------------------------------- kerning_data_u16 ---
+/* Big endian value at offset, 0 when out of the table */
+static unsigned int
+kerning_data_u16( const kerning_data_t *data, FT_ULong offset )
+{
+    if( !kerning_data_has( data, offset, 2 ) )
+        return 0;
+    return (data->bytes[offset] << 8) | data->bytes[offset+1];
+}
+
+// ------------------------------------------------------- kerning_data_s16 ---
+static int
+kerning_data_s16( const kerning_data_t *data, FT_ULong offset )
+{
+    return (int16_t) kerning_data_u16( data, offset );
+}
+
+// ------------------------------------------------------- kerning_data_u32 ---
+static FT_ULong
+kerning_data_u32( const kerning_data_t *data, FT_ULong offset )
+{
+    return ((FT_ULong) kerning_data_u16( data, offset ) << 16)
+         | kerning_data_u16( data, offset + 2 );
+}
+
+// ------------------------------------------------------ kerning_data_load ---
+static int
+kerning_data_load( kerning_data_t *data, FT_Face face, FT_ULong tag )
+{
+    data->bytes = NULL;
+    data->length = 0;
+    if( FT_Load_Sfnt_Table( face, tag, 0, NULL, &data->length )
+        || !data->length )
+        return 0;
+
+    data->bytes = (FT_Byte *) malloc( data->length );
+    if( data->bytes == NULL )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    if( FT_Load_Sfnt_Table( face, tag, 0, data->bytes, &data->length ) )
+    {
+        free( data->bytes );
+        data->bytes = NULL;
+        data->length = 0;
+        return 0;
+    }
+    return 1;
+}
+
+// -------------------------------------------------------- kerning_compare ---
+static int
+kerning_compare( const void *a, const void *b )
+{
+    const kerning_entry_t *p = (const kerning_entry_t *) a;
+    const kerning_entry_t *q = (const kerning_entry_t *) b;
+
+    if( p->left != q->left )
+        return p->left < q->left ? -1 : 1;
+    if( p->right != q->right )
+        return p->right < q->right ? -1 : 1;
+    if( p->order != q->order )
+        return p->order < q->order ? -1 : 1;
+    return 0;
+}
+
+// ----------------------------------------------- kerning_compare_by_right ---
+static int
+kerning_compare_by_right( const void *a, const void *b )
+{
+    const kerning_pair_t *p = (const kerning_pair_t *) a;
+    const kerning_pair_t *q = (const kerning_pair_t *) b;
+
+    if( p->right != q->right )
+        return p->right < q->right ? -1 : 1;
+    if( p->left != q->left )
+        return p->left < q->left ? -1 : 1;
+    return 0;
+}
+
+// ------------------------------------------------------ kerning_read_kern ---
+/* Format 0 horizontal subtables of a 'kern' table, in either the
+ * Microsoft (16 bits header) or the Apple (32 bits header) layout. */
+static int
+kerning_read_kern( vector_t *entries, const kerning_data_t *data,
+                   FT_ULong num_glyphs )
+{
+    FT_ULong i, j, count, offset, size, header, pairs;
+    unsigned int coverage;
+    int apple;
+    kerning_entry_t entry;
+
+    if( !kerning_data_has( data, 0, 4 ) )
+        return 0;
+
+    apple = kerning_data_u16( data, 0 ) == 1;
+    if( apple )
+    {
+        count = kerning_data_u32( data, 4 );
+        offset = 8;
+        header = 8;
+    }
+    else if( kerning_data_u16( data, 0 ) == 0 )
+    {
+        count = kerning_data_u16( data, 2 );
+        offset = 4;
+        header = 6;
+    }
+    else
+    {
+        return 0;
+    }
+
+    entry.order = 0;
+    for( i = 0; i < count && kerning_data_has( data, offset, header ); ++i )
+    {
+        if( apple )
+        {
+            size = kerning_data_u32( data, offset );
+            coverage = kerning_data_u16( data, offset + 4 );
+            /* Format 0, not vertical, cross-stream nor variation */
+            coverage = (coverage & 0xE0FF) == 0;
+        }
+        else
+        {
+            size = kerning_data_u16( data, offset + 2 );
+            coverage = kerning_data_u16( data, offset + 4 );
+
+            /* The 16 bits length of large format 0 subtables overflows,
+             * it is recomputed from the number of pairs */
+            if( (coverage >> 8) == 0 )
+                size = header + 8 + 6 * kerning_data_u16( data, offset + header );
+
+            /* Format 0, horizontal, neither minimum nor cross-stream */
+            coverage = (coverage & 0xFF07) == 0x0001;
+        }
+
+        if( coverage )
+        {
+            pairs = kerning_data_u16( data, offset + header );
+            for( j = 0; j < pairs; ++j )
+            {
+                FT_ULong record = offset + header + 8 + 6 * j;
+                if( !kerning_data_has( data, record, 6 ) )
+                    break;
+                entry.left = kerning_data_u16( data, record );
+                entry.right = kerning_data_u16( data, record + 2 );
+                entry.value = kerning_data_s16( data, record + 4 );
+                if( entry.left < num_glyphs && entry.right < num_glyphs )
+                    vector_push_back( entries, &entry );
+            }
+        }
+
+        /* Some fonts have a wrong size for a single subtable */
+        if( size < header )
+            break;
+        offset += size;
+    }
+    return 1;
+}
+
+// ----------------------------------------------------- kerning_value_size ---
+/* Size in bytes of a value record of the given format */
+static FT_ULong
+kerning_value_size( unsigned int format )
+{
+    FT_ULong size = 0;
+
+    for( format &= 0xFF; format; format >>= 1 )
+        size += 2 * (format & 1);
+    return size;
+}
+
+// -------------------------------------------------- kerning_value_advance ---
+/* Horizontal advance adjustment of a value record */
+static int32_t
+kerning_value_advance( const kerning_data_t *data,
+                       FT_ULong offset, unsigned int format )
+{
+    if( !(format & 0x0004) )
+        return 0;
+    return kerning_data_s16( data,
+                             offset + kerning_value_size( format & 0x0003 ) );
+}
+
+// --------------------------------------------------- kerning_coverage_fill ---
+/* coverage[glyph] is set to the coverage index of glyph, -1 if absent */
+static void
+kerning_coverage_fill( const kerning_data_t *data, FT_ULong offset,
+                       int32_t *coverage, FT_ULong num_glyphs )
+{
+    FT_ULong i, count, glyph, last;
+    int32_t index;
+
+    memset( coverage, 0xFF, num_glyphs * sizeof(int32_t) );
+    count = kerning_data_u16( data, offset + 2 );
+
+    if( kerning_data_u16( data, offset ) == 1 )
+    {
+        for( i = 0; i < count && kerning_data_has( data, offset + 4 + 2*i, 2 ); ++i )
+        {
+            glyph = kerning_data_u16( data, offset + 4 + 2*i );
+            if( glyph < num_glyphs )
+                coverage[glyph] = (int32_t) i;
+        }
+    }
+    else if( kerning_data_u16( data, offset ) == 2 )
+    {
+        for( i = 0; i < count && kerning_data_has( data, offset + 4 + 6*i, 6 ); ++i )
+        {
+            glyph = kerning_data_u16( data, offset + 4 + 6*i );
+            last = kerning_data_u16( data, offset + 4 + 6*i + 2 );
+            index = (int32_t) kerning_data_u16( data, offset + 4 + 6*i + 4 );
+            for( ; glyph <= last && glyph < num_glyphs; ++glyph, ++index )
+                coverage[glyph] = index;
+        }
+    }
+}
+
+// ------------------------------------------------------ kerning_class_fill ---
+/* classes[glyph] is set to the class of glyph, 0 if not listed */
+static void
+kerning_class_fill( const kerning_data_t *data, FT_ULong offset,
+                    uint16_t *classes, FT_ULong num_glyphs )
+{
+    FT_ULong i, count, glyph, last;
+    uint16_t value;
+
+    memset( classes, 0, num_glyphs * sizeof(uint16_t) );
+
+    if( kerning_data_u16( data, offset ) == 1 )
+    {
+        glyph = kerning_data_u16( data, offset + 2 );
+        count = kerning_data_u16( data, offset + 4 );
+        for( i = 0; i < count && glyph + i < num_glyphs; ++i )
+            classes[glyph + i] = kerning_data_u16( data, offset + 6 + 2*i );
+    }
+    else if( kerning_data_u16( data, offset ) == 2 )
+    {
+        count = kerning_data_u16( data, offset + 2 );
+        for( i = 0; i < count && kerning_data_has( data, offset + 4 + 6*i, 6 ); ++i )
+        {
+            glyph = kerning_data_u16( data, offset + 4 + 6*i );
+            last = kerning_data_u16( data, offset + 4 + 6*i + 2 );
+            value = kerning_data_u16( data, offset + 4 + 6*i + 4 );
+            for( ; glyph <= last && glyph < num_glyphs; ++glyph )
+                classes[glyph] = value;
+        }
+    }
+}
+
+// ------------------------------------------------ kerning_read_pair_format1 ---
+/* Explicit pairs: one set of (second glyph, values) per covered glyph */
+static void
+kerning_read_pair_format1( vector_t *entries, const kerning_data_t *data,
+                           FT_ULong offset, uint32_t order,
+                           const int32_t *coverage, const unsigned char *claimed,
+                           FT_ULong num_glyphs )
+{
+    unsigned int format1 = kerning_data_u16( data, offset + 4 );
+    unsigned int format2 = kerning_data_u16( data, offset + 6 );
+    FT_ULong sets = kerning_data_u16( data, offset + 8 );
+    FT_ULong record = 2 + kerning_value_size( format1 ) + kerning_value_size( format2 );
+    FT_ULong glyph, i, count, set;
+    kerning_entry_t entry;
+
+    entry.order = order;
+    for( glyph = 0; glyph < num_glyphs; ++glyph )
+    {
+        if( coverage[glyph] < 0 || (FT_ULong) coverage[glyph] >= sets
+            || claimed[glyph] )
+            continue;
+
+        set = kerning_data_u16( data, offset + 10 + 2 * coverage[glyph] );
+        if( !set )
+            continue;
+        set += offset;
+        count = kerning_data_u16( data, set );
+        entry.left = glyph;
+        for( i = 0; i < count; ++i )
+        {
+            FT_ULong pair = set + 2 + i * record;
+            if( !kerning_data_has( data, pair, record ) )
+                break;
+
+            /* Null adjustments are kept, they hide later subtables */
+            entry.right = kerning_data_u16( data, pair );
+            entry.value = kerning_value_advance( data, pair + 2, format1 );
+            if( entry.right < num_glyphs )
+                vector_push_back( entries, &entry );
+        }
+    }
+}
+
+// ------------------------------------------------ kerning_read_pair_format2 ---
+/* Class pairs: a value for each (first class, second class) couple, first
+ * classes are applied to covered glyphs and second classes to any glyph. */
+static void
+kerning_read_pair_format2( vector_t *entries, const kerning_data_t *data,
+                           FT_ULong offset, uint32_t order,
+                           const int32_t *coverage, unsigned char *claimed,
+                           uint16_t *classes, uint32_t *members,
+                           FT_ULong num_glyphs )
+{
+    unsigned int format1 = kerning_data_u16( data, offset + 4 );
+    unsigned int format2 = kerning_data_u16( data, offset + 6 );
+    FT_ULong class1_count = kerning_data_u16( data, offset + 12 );
+    FT_ULong class2_count = kerning_data_u16( data, offset + 14 );
+    FT_ULong record = kerning_value_size( format1 ) + kerning_value_size( format2 );
+    FT_ULong glyph, c1, c2, i, value;
+    uint32_t *first;
+    kerning_entry_t entry;
+
+    if( !class2_count
+        || !kerning_data_has( data, offset + 16,
+                              class1_count * class2_count * record ) )
+        return;
+
+    /* Group glyphs by second class, class 0 (every glyph not listed)
+     * is left out, adjusting against it would concern the whole font. */
+    first = (uint32_t *) calloc( class2_count + 1, sizeof(uint32_t) );
+    if( first == NULL )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    kerning_class_fill( data, offset + kerning_data_u16( data, offset + 10 ),
+                        classes, num_glyphs );
+    for( glyph = 0; glyph < num_glyphs; ++glyph )
+        if( classes[glyph] && classes[glyph] < class2_count )
+            first[classes[glyph]]++;
+    for( c2 = 0, i = 0; c2 <= class2_count; ++c2 )
+    {
+        value = first[c2];
+        first[c2] = i;
+        i += value;
+    }
+    for( glyph = 0; glyph < num_glyphs; ++glyph )
+        if( classes[glyph] && classes[glyph] < class2_count )
+            members[first[classes[glyph]]++] = glyph;
+    for( c2 = class2_count; c2 > 0; --c2 )
+        first[c2] = first[c2-1];
+    first[0] = 0;
+
+    kerning_class_fill( data, offset + kerning_data_u16( data, offset + 8 ),
+                        classes, num_glyphs );
+    entry.order = order;
+    for( glyph = 0; glyph < num_glyphs; ++glyph )
+    {
+        if( coverage[glyph] < 0 || claimed[glyph] )
+            continue;
+
+        /* Every pair starting with this glyph is settled by this subtable */
+        claimed[glyph] = 1;
+        c1 = classes[glyph];
+        if( c1 >= class1_count )
+            continue;
+
+        entry.left = glyph;
+        for( c2 = 1; c2 < class2_count; ++c2 )
+        {
+            entry.value = kerning_value_advance(
+                data, offset + 16 + (c1 * class2_count + c2) * record, format1 );
+            if( !entry.value )
+                continue;
+            for( i = first[c2]; i < first[c2+1]; ++i )
+            {
+                entry.right = members[i];
+                vector_push_back( entries, &entry );
+            }
+        }
+    }
+    free( first );
+}
+
+// ------------------------------------------------------ kerning_read_gpos ---
+/* Pair adjustment lookups of the 'kern' feature of a 'GPOS' table. Within
+ * a lookup, the first subtable covering a pair gives its value, the values
+ * of the different lookups add up. */
+static int
+kerning_read_gpos( vector_t *entries, const kerning_data_t *data,
+                   FT_ULong num_glyphs )
+{
+    FT_ULong features, lookups, lookup, subtable;
+    FT_ULong i, j, count, feature_count, lookup_count, subtable_count;
+    unsigned char *selected, *claimed;
+    int32_t *coverage;
+    uint16_t *classes;
+    uint32_t *members;
+    vector_t *collected;
+    kerning_entry_t *entry, *last;
+    int found = 0;
+
+    if( !kerning_data_has( data, 0, 10 ) || kerning_data_u16( data, 0 ) != 1 )
+        return 0;
+
+    features = kerning_data_u16( data, 6 );
+    lookups = kerning_data_u16( data, 8 );
+    lookup_count = kerning_data_u16( data, lookups );
+    if( !features || !lookups || !lookup_count )
+        return 0;
+
+    /* Lookups referenced by any 'kern' feature, whatever the script */
+    selected = (unsigned char *) calloc( lookup_count, 1 );
+    if( !selected )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    feature_count = kerning_data_u16( data, features );
+    for( i = 0; i < feature_count; ++i )
+    {
+        FT_ULong record = features + 2 + 6 * i;
+        FT_ULong feature;
+        if( !kerning_data_has( data, record, 6 ) )
+            break;
+        if( kerning_data_u32( data, record ) != KERN_FEATURE )
+            continue;
+        feature = features + kerning_data_u16( data, record + 4 );
+        count = kerning_data_u16( data, feature + 2 );
+        for( j = 0; j < count; ++j )
+        {
+            FT_ULong index = kerning_data_u16( data, feature + 4 + 2 * j );
+            if( index < lookup_count )
+                selected[index] = found = 1;
+        }
+    }
+    if( !found )
+    {
+        free( selected );
+        return 0;
+    }
+
+    claimed  = (unsigned char *) malloc( num_glyphs );
+    coverage = (int32_t *) malloc( num_glyphs * sizeof(int32_t) );
+    classes  = (uint16_t *) malloc( num_glyphs * sizeof(uint16_t) );
+    members  = (uint32_t *) malloc( num_glyphs * sizeof(uint32_t) );
+    if( !claimed || !coverage || !classes || !members )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    collected = vector_new( sizeof(kerning_entry_t) );
+
+    for( i = 0; i < lookup_count; ++i )
+    {
+        unsigned int type;
+
+        if( !selected[i] )
+            continue;
+
+        lookup = lookups + kerning_data_u16( data, lookups + 2 + 2 * i );
+        type = kerning_data_u16( data, lookup );
+        subtable_count = kerning_data_u16( data, lookup + 4 );
+        if( type != 2 && type != 9 )
+            continue;
+
+        memset( claimed, 0, num_glyphs );
+        vector_clear( collected );
+        for( j = 0; j < subtable_count; ++j )
+        {
+            subtable = lookup + kerning_data_u16( data, lookup + 6 + 2 * j );
+
+            /* Extension subtables hold a 32 bits offset to the real one */
+            if( type == 9 )
+            {
+                if( kerning_data_u16( data, subtable + 2 ) != 2 )
+                    continue;
+                subtable += kerning_data_u32( data, subtable + 4 );
+            }
+            if( !kerning_data_has( data, subtable, 10 ) )
+                continue;
+
+            kerning_coverage_fill( data,
+                                   subtable + kerning_data_u16( data, subtable + 2 ),
+                                   coverage, num_glyphs );
+            if( kerning_data_u16( data, subtable ) == 1 )
+                kerning_read_pair_format1( collected, data, subtable, j,
+                                           coverage, claimed, num_glyphs );
+            else if( kerning_data_u16( data, subtable ) == 2 )
+                kerning_read_pair_format2( collected, data, subtable, j,
+                                           coverage, claimed, classes,
+                                           members, num_glyphs );
+        }
+
+        /* Keep the pairs of the first subtable only */
+        if( collected->size )
+        {
+            qsort( collected->items, collected->size, collected->item_size,
+                   kerning_compare );
+            last = NULL;
+            for( j = 0; j < collected->size; ++j )
+            {
+                entry = (kerning_entry_t *) vector_get( collected, j );
+                if( last && last->left == entry->left
+                    && last->right == entry->right )
+                    continue;
+                entry->order = (uint32_t) i;
+                vector_push_back( entries, entry );
+                last = entry;
+            }
+        }
+    }
+
+    vector_delete( collected );
+    free( members );
+    free( classes );
+    free( coverage );
+    free( claimed );
+    free( selected );
+    return 1;
+}
+
+// ------------------------------------------------------ kerning_table_new ---
+kerning_table_t *
+kerning_table_new( FT_Face face )
+{
+    kerning_table_t *self;
+    kerning_data_t data;
+    vector_t *entries;
+    kerning_entry_t *entry;
+    FT_ULong num_glyphs;
+    size_t i;
+    int found = 0;
+
+    assert( face );
+
+    if( !FT_IS_SFNT( face ) || face->num_glyphs <= 0 )
+        return NULL;
+
+    num_glyphs = (FT_ULong) face->num_glyphs;
+    entries = vector_new( sizeof(kerning_entry_t) );
+
+    /* 'GPOS' supersedes 'kern' when both are present */
+    if( kerning_data_load( &data, face, TTAG_GPOS ) )
+    {
+        found = kerning_read_gpos( entries, &data, num_glyphs );
+        free( data.bytes );
+    }
+    if( !found && kerning_data_load( &data, face, TTAG_kern ) )
+    {
+        found = kerning_read_kern( entries, &data, num_glyphs );
+        free( data.bytes );
+    }
+    if( !found )
+    {
+        vector_delete( entries );
+        return NULL;
+    }
+
+    self = (kerning_table_t *) malloc( sizeof(kerning_table_t) );
+    if( self == NULL )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    self->pairs = vector_new( sizeof(kerning_pair_t) );
+
+    /* Sum up the adjustments found for a same pair, dropping the pairs
+     * cancelling out */
+    qsort( entries->items, entries->size, entries->item_size, kerning_compare );
+    for( i = 0; i < entries->size; )
+    {
+        kerning_pair_t p;
+
+        entry = (kerning_entry_t *) vector_get( entries, i );
+        p.left = entry->left;
+        p.right = entry->right;
+        p.value = 0;
+        for( ; i < entries->size; ++i )
+        {
+            entry = (kerning_entry_t *) vector_get( entries, i );
+            if( entry->left != p.left || entry->right != p.right )
+                break;
+            p.value += entry->value;
+        }
+        if( p.value )
+            vector_push_back( self->pairs, &p );
+    }
+    vector_delete( entries );
+
+    self->pairs_by_right = vector_new( sizeof(kerning_pair_t) );
+    vector_push_back_data( self->pairs_by_right,
+                           self->pairs->items, self->pairs->size );
+    qsort( self->pairs_by_right->items, self->pairs_by_right->size,
+           self->pairs_by_right->item_size, kerning_compare_by_right );
+
+    return self;
+}
+
+// --------------------------------------------------- kerning_table_delete ---
+void
+kerning_table_delete( kerning_table_t * self )
+{
+    assert( self );
+
+    vector_delete( self->pairs );
+    vector_delete( self->pairs_by_right );
+    free( self );
+}
+
+// ------------------------------------------------------ kerning_table_find ---
+/* Range of the pairs sorted on the given member holding the given glyph */
+static size_t
+kerning_table_find( const vector_t *pairs, uint32_t glyph, int right,
+                    size_t *first )
+{
+    size_t lo = 0, hi = pairs->size, begin;
+    const kerning_pair_t *pair;
+
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        pair = (const kerning_pair_t *) vector_get( pairs, mid );
+        if( (right ? pair->right : pair->left) < glyph )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    begin = lo;
+    hi = pairs->size;
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        pair = (const kerning_pair_t *) vector_get( pairs, mid );
+        if( (right ? pair->right : pair->left) <= glyph )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    *first = begin;
+    return lo - begin;
+}
+
+// ------------------------------------------------- kerning_table_find_left ---
+size_t
+kerning_table_find_left( const kerning_table_t * self,
+                         uint32_t glyph,
+                         size_t * first )
+{
+    assert( self );
+    assert( first );
+
+    return kerning_table_find( self->pairs, glyph, 0, first );
+}
+
+// ------------------------------------------------ kerning_table_find_right ---
+size_t
+kerning_table_find_right( const kerning_table_t * self,
+                          uint32_t glyph,
+                          size_t * first )
+{
+    assert( self );
+    assert( first );
+
+    return kerning_table_find( self->pairs_by_right, glyph, 1, first );
+}
@@ -0,0 +1,185 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#ifndef __KERNING_TABLE_H__
+#define __KERNING_TABLE_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vector.h"
+
+#ifdef __cplusplus
+namespace ftgl {
+#endif
+
+/**
+ * @file   kerning-table.h
+ *
+ * @defgroup kerning-table Kerning table
+ *
+ * Pair adjustments read in bulk from the 'GPOS' (pair positioning lookups
+ * of the 'kern' feature) or 'kern' (format 0 subtables) font tables.
+ *
+ * Class based pairs are expanded to glyph pairs, so that every pair
+ * involving a given glyph can be enumerated directly instead of probing
+ * each glyph couple with FT_Get_Kerning.
+ *
+ * <b>Example Usage</b>:
+ * @code
+ * #include "kerning-table.h"
+ *
+ * int main( int arrgc, char *argv[] )
+ * {
+ *     kerning_table_t * table = kerning_table_new( face );
+ *     size_t first, count;
+ *
+ *     count = kerning_table_find_left( table, glyph_index, &first );
+ *     ...
+ *     kerning_table_delete( table );
+ *     return 0;
+ * }
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * A kerning pair between two glyph indices.
+ */
+typedef struct kerning_pair_t
+{
+    /**
+     * Glyph index of the left glyph.
+     */
+    uint32_t left;
+
+    /**
+     * Glyph index of the right glyph.
+     */
+    uint32_t right;
+
+    /**
+     * Horizontal adjustment in font units.
+     */
+    int32_t value;
+
+} kerning_pair_t;
+
+
+/**
+ * Kerning table structure.
+ */
+typedef struct kerning_table_t
+{
+    /**
+     * Pairs sorted by left then right glyph index.
+     */
+    vector_t * pairs;
+
+    /**
+     * The same pairs sorted by right then left glyph index.
+     */
+    vector_t * pairs_by_right;
+
+} kerning_table_t;
+
+
+/**
+ * Reads the kerning pairs of a face.
+ *
+ * Pairs are taken from the 'GPOS' table when it has a 'kern' feature, from
+ * the 'kern' table otherwise.
+ *
+ * @param face  A FreeType face
+ *
+ * @return  A new kerning table or NULL if the face has no kerning data
+ *          that could be read.
+ */
+  kerning_table_t *
+  kerning_table_new( FT_Face face );
+
+
+/**
+ * Deletes a kerning table.
+ *
+ * @param self  A kerning table
+ */
+  void
+  kerning_table_delete( kerning_table_t * self );
+
+
+/**
+ * Finds the pairs having a given glyph on the left.
+ *
+ * @param self   A kerning table
+ * @param glyph  Glyph index of the left glyph
+ * @param first  Index of the first matching pair in self->pairs
+ *
+ * @return  Number of matching pairs
+ */
+  size_t
+  kerning_table_find_left( const kerning_table_t * self,
+                           uint32_t glyph,
+                           size_t * first );
+
+
+/**
+ * Finds the pairs having a given glyph on the right.
+ *
+ * @param self   A kerning table
+ * @param glyph  Glyph index of the right glyph
+ * @param first  Index of the first matching pair in self->pairs_by_right
+ *
+ * @return  Number of matching pairs
+ */
+  size_t
+  kerning_table_find_right( const kerning_table_t * self,
+                            uint32_t glyph,
+                            size_t * first );
+
+/** @} */
+
+#ifdef __cplusplus
+}
+}
+#endif
+
+#endif /* __KERNING_TABLE_H__ */
@@ -51,6 +51,29 @@ void print_help()
 }
 
 
+// ---------------------------------------------------------- glyph kerning ---
+void glyph_kerning( texture_font_t *font, texture_glyph_t *glyph,
+                    vector_t *kerning )
+{
+    size_t i;
+
+    // Pairs having the glyph on the right, from the font kerning index
+    vector_clear( kerning );
+    for( i=0; i < font->glyphs->size; ++i )
+    {
+        texture_glyph_t *other = *(texture_glyph_t **) vector_get( font->glyphs, i );
+        kerning_t k = {other->codepoint, 0};
+
+        if( other->codepoint == (uint32_t)(-1) )
+            continue;
+
+        k.kerning = texture_font_get_kerning( font, other->codepoint, glyph->codepoint );
+        if( k.kerning != 0 )
+            vector_push_back( kerning, &k );
+    }
+}
+
+
 // ------------------------------------------------------------------- main ---
 int main( int argc, char **argv )
 {
@@ -333,13 +356,15 @@ int main( int argc, char **argv )
     size_t texture_size = atlas->width * atlas->height *atlas->depth;
     size_t glyph_count = font->glyphs->size;
     size_t max_kerning_count = 1;
+    vector_t *kerning = vector_new( sizeof(kerning_t) );
     for( i=0; i < glyph_count; ++i )
     {
         texture_glyph_t *glyph = *(texture_glyph_t **) vector_get( font->glyphs, i );
 
-        if( vector_size(glyph->kerning) > max_kerning_count )
+        glyph_kerning( font, glyph, kerning );
+        if( vector_size(kerning) > max_kerning_count )
         {
-            max_kerning_count = vector_size(glyph->kerning);
+            max_kerning_count = vector_size(kerning);
         }
     }
 
@@ -517,18 +542,19 @@ int main( int argc, char **argv )
         fprintf( file, "%d, %d, ", glyph->offset_x, glyph->offset_y );
         fprintf( file, "%ff, %ff, ", glyph->advance_x, glyph->advance_y );
         fprintf( file, "%ff, %ff, %ff, %ff, ", glyph->s0, glyph->t0, glyph->s1, glyph->t1 );
-        fprintf( file, "%zu, ", vector_size(glyph->kerning) );
-        if (vector_size(glyph->kerning) == 0) {
+        glyph_kerning( font, glyph, kerning );
+        fprintf( file, "%zu, ", vector_size(kerning) );
+        if (vector_size(kerning) == 0) {
             fprintf( file, "0" );
         }
         else {
             fprintf( file, "{ " );
-            for( j=0; j < vector_size(glyph->kerning); ++j )
+            for( j=0; j < vector_size(kerning); ++j )
             {
-                kerning_t *kerning = (kerning_t *) vector_get( glyph->kerning, j);
+                kerning_t *k = (kerning_t *) vector_get( kerning, j);
 
-                fprintf( file, "{%u, %ff}", kerning->codepoint, kerning->kerning );
-                if( j < (vector_size(glyph->kerning)-1))
+                fprintf( file, "{%u, %ff}", k->codepoint, k->kerning );
+                if( j < (vector_size(kerning)-1))
                 {
                     fprintf( file, ", " );
                 }
@@ -538,6 +564,7 @@ int main( int argc, char **argv )
         fprintf( file, " },\n" );
     }
     fprintf( file, " }\n};\n" );
+    vector_delete( kerning );
 
     fprintf( file,
         "#ifdef __cplusplus\n"
@@ -84,13 +84,18 @@ varying vec4 vcolor;
 varying vec2 vtex_coord;
 varying float vshift;
 varying float vgamma;
+varying float vchannel;
 
 void main()
 {
     // LCD Off
     if( pixel.z == 1.0)
     {
-        float a = texture2D(tex, vtex_coord).r;
+        // Glyphs of a channel-packed atlas lie in any of its channels
+        vec4 texel = texture2D(tex, vtex_coord);
+        float a = vchannel < 0.5 ? texel.r :
+                  vchannel < 1.5 ? texel.g :
+                  vchannel < 2.5 ? texel.b : texel.a;
         gl_FragColor = vcolor * pow( a, 1.0/vgamma );
         return;
     }
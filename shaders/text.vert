@@ -42,16 +42,19 @@ attribute vec4 color;
 attribute vec2 tex_coord;
 attribute float ashift;
 attribute float agamma;
+attribute float achannel;
 
 varying vec4 vcolor;
 varying vec2 vtex_coord;
 varying float vshift;
 varying float vgamma;
+varying float vchannel;
 
 void main()
 {
     vshift = ashift;
     vgamma = agamma;
+    vchannel = achannel;
     vcolor = color;
     vtex_coord = tex_coord;
     gl_Position = projection*(view*(model*vec4(vertex,1.0)));
@@ -41,12 +41,12 @@
 #include "utf8-utils.h"
 #include "math.h"
 
-#define SET_GLYPH_VERTEX(value,x0,y0,z0,s0,t0,r,g,b,a,sh,gm) { \
-	glyph_vertex_t *gv=&value;                                 \
-	gv->x=x0; gv->y=y0; gv->z=z0;                              \
-	gv->u=s0; gv->v=t0;                                        \
-	gv->r=r; gv->g=g; gv->b=b; gv->a=a;                        \
-	gv->shift=sh; gv->gamma=gm;}
+#define SET_GLYPH_VERTEX(value,x0,y0,z0,s0,t0,r,g,b,a,sh,gm,ch) { \
+	glyph_vertex_t *gv=&value;                                    \
+	gv->x=x0; gv->y=y0; gv->z=z0;                                 \
+	gv->u=s0; gv->v=t0;                                           \
+	gv->r=r; gv->g=g; gv->b=b; gv->a=a;                           \
+	gv->shift=sh; gv->gamma=gm; gv->channel=(float)(ch);}
 
 // ----------------------------------------------------------------------------
 
@@ -68,8 +68,9 @@ text_buffer_new_with_program( size_t depth,
 {
     text_buffer_t *self = (text_buffer_t *) malloc (sizeof(text_buffer_t));
     self->buffer = vertex_buffer_new(
-                                     "vertex:3f,tex_coord:2f,color:4f,ashift:1f,agamma:1f" );
+                                     "vertex:3f,tex_coord:2f,color:4f,ashift:1f,agamma:1f,achannel:1f" );
     self->manager = font_manager_new( 512, 512, depth );
+    self->pages = vector_new( sizeof(size_t) );
     self->shader = program;
     self->shader_texture = glGetUniformLocation(self->shader, "tex");
     self->shader_pixel = glGetUniformLocation(self->shader, "pixel");
@@ -92,6 +93,13 @@ text_buffer_new_with_program( size_t depth,
 void
 text_buffer_delete( text_buffer_t * self )
 {
+    texture_atlas_t *page;
+
+    for( page = self->manager->atlas->next; page; page = page->next )
+    {
+        glDeleteTextures( 1, &page->id );
+    }
+    vector_delete( self->pages );
     vector_delete( self->lines );
     font_manager_delete( self->manager );
     vertex_buffer_delete( self->buffer );
@@ -106,6 +114,7 @@ text_buffer_clear( text_buffer_t * self )
     assert( self );
 
     vertex_buffer_clear( self->buffer );
+    vector_clear( self->pages );
     self->line_start = 0;
     self->line_ascender = 0;
     self->line_descender = 0;
@@ -117,6 +126,58 @@ text_buffer_clear( text_buffer_t * self )
 }
 
 
+// ----------------------------------------------------------------------------
+void
+text_buffer_reserve( text_buffer_t * self, size_t length )
+{
+    assert( self );
+
+    vertex_buffer_reserve( self->buffer, 4 * length, 6 * length, length );
+    vector_reserve( self->pages, vector_size( self->pages ) + length );
+}
+
+
+// ----------------------------------------------------------------------------
+static void
+text_buffer_render_pages( text_buffer_t * self )
+{
+    vertex_buffer_t * buffer = self->buffer;
+    texture_atlas_t * page;
+    size_t i, index, start, count;
+
+    for( page = self->manager->atlas; page; page = page->next )
+    {
+        texture_atlas_upload( page );
+    }
+
+    vertex_buffer_render_setup( buffer, GL_TRIANGLES );
+    for( index = 0, page = self->manager->atlas; page; page = page->next, ++index )
+    {
+        glBindTexture( GL_TEXTURE_2D, page->id );
+
+        // Draw runs of consecutive items lying on this page
+        for( i = 0; i < vector_size( buffer->items ); )
+        {
+            if( *(size_t *) vector_get( self->pages, i ) != index )
+            {
+                ++i;
+                continue;
+            }
+            start = ((ivec4 *) vector_get( buffer->items, i ))->istart;
+            count = 0;
+            for( ; i < vector_size( buffer->items ) &&
+                   *(size_t *) vector_get( self->pages, i ) == index; ++i )
+            {
+                count += ((ivec4 *) vector_get( buffer->items, i ))->icount;
+            }
+            glDrawElements( GL_TRIANGLES, count, GL_UNSIGNED_INT,
+                            (void *)(start*sizeof(GLuint)) );
+        }
+    }
+    vertex_buffer_render_finish( buffer );
+}
+
+
 // ----------------------------------------------------------------------------
 void
 text_buffer_render( text_buffer_t * self )
@@ -153,7 +214,10 @@ text_buffer_render( text_buffer_t * self )
                  1.0f/self->manager->atlas->width,
                  1.0f/self->manager->atlas->height,
                  (float)self->manager->atlas->depth );
-    vertex_buffer_render( self->buffer, GL_TRIANGLES );
+    if( self->manager->max_pages > 1 )
+        text_buffer_render_pages( self );
+    else
+        vertex_buffer_render( self->buffer, GL_TRIANGLES );
     glBindTexture( GL_TEXTURE_2D, 0 );
     glBlendColor( 0, 0, 0, 0 );
     glUseProgram( 0 );
@@ -198,6 +262,30 @@ text_buffer_move_last_line( text_buffer_t * self, float dy )
 }
 
 
+// ----------------------------------------------------------------------------
+// text_buffer_rescale (internal use only)
+//
+//  Scales texture coordinates of the text already in the buffer once the
+//  atlas has grown from width x height
+//
+static void
+text_buffer_rescale( text_buffer_t * self, size_t width, size_t height )
+{
+    float sx = width / (float) self->manager->atlas->width;
+    float sy = height / (float) self->manager->atlas->height;
+    size_t i;
+
+    for( i = 0; i < vector_size( self->buffer->vertices ); ++i )
+    {
+        glyph_vertex_t * vertex =
+            (glyph_vertex_t *) vector_get( self->buffer->vertices, i );
+        vertex->u *= sx;
+        vertex->v *= sy;
+    }
+    self->buffer->state = 1;
+}
+
+
 // ----------------------------------------------------------------------------
 // text_buffer_finish_line (internal use only)
 // 
@@ -260,18 +348,15 @@ text_buffer_finish_line( text_buffer_t * self, vec2 * pen, bool advancePen )
 }
 
 // ----------------------------------------------------------------------------
-void
-text_buffer_add_text( text_buffer_t * self,
-                      vec2 * pen, markup_t * markup,
-                      const char * text, size_t length )
+static int
+text_buffer_begin_run( text_buffer_t * self,
+                       vec2 * pen, markup_t * markup )
 {
     font_manager_t * manager = self->manager;
-    size_t i;
-    const char * prev_character = NULL;
 
     if( markup == NULL )
     {
-        return;
+        return 0;
     }
 
     if( !markup->font )
@@ -284,10 +369,6 @@ text_buffer_add_text( text_buffer_t * self,
         }
     }
 
-    if( length == 0 )
-    {
-        length = utf8_strlen(text);
-    }
     if( vertex_buffer_size( self->buffer ) == 0 )
     {
         self->origin = *pen;
@@ -306,22 +387,77 @@ text_buffer_add_text( text_buffer_t * self,
             text_buffer_finish_line(self, pen, false);
         }
     }
+    return 1;
+}
+
+// ----------------------------------------------------------------------------
+void
+text_buffer_add_text( text_buffer_t * self,
+                      vec2 * pen, markup_t * markup,
+                      const char * text, size_t length )
+{
+    size_t i;
+    uint32_t current, previous = 0;
 
-    for( i = 0; utf8_strlen( text + i ) && length; i += utf8_surrogate_len( text + i ) )
+    if( !text_buffer_begin_run( self, pen, markup ) )
     {
-        text_buffer_add_char( self, pen, markup, text + i, prev_character );
-        prev_character = text + i;
+        return;
+    }
+
+    if( length == 0 )
+    {
+        length = utf8_strlen(text);
+    }
+
+    // Each character is decoded once and kept as the next one's previous
+    for( i = 0; text[i] && length; i += utf8_surrogate_len( text + i ) )
+    {
+        current = utf8_to_utf32( text + i );
+        text_buffer_add_char_utf32( self, pen, markup, current, previous );
+        previous = current;
         length--;
     }
 
     self->last_pen_y = pen->y;
 }
 
+// ----------------------------------------------------------------------------
+void
+text_buffer_add_codepoints( text_buffer_t * self,
+                            vec2 * pen, markup_t * markup,
+                            const uint32_t * codepoints, size_t length )
+{
+    size_t i;
+
+    if( !text_buffer_begin_run( self, pen, markup ) )
+    {
+        return;
+    }
+
+    for( i = 0; i < length; ++i )
+    {
+        text_buffer_add_char_utf32( self, pen, markup, codepoints[i],
+                                    i ? codepoints[i-1] : 0 );
+    }
+
+    self->last_pen_y = pen->y;
+}
+
 // ----------------------------------------------------------------------------
 void
 text_buffer_add_char( text_buffer_t * self,
                       vec2 * pen, markup_t * markup,
                       const char * current, const char * previous )
+{
+    text_buffer_add_char_utf32( self, pen, markup, utf8_to_utf32( current ),
+                                previous ? utf8_to_utf32( previous ) : 0 );
+}
+
+// ----------------------------------------------------------------------------
+void
+text_buffer_add_char_utf32( text_buffer_t * self,
+                            vec2 * pen, markup_t * markup,
+                            uint32_t current, uint32_t previous )
 {
     size_t vcount = 0;
     size_t icount = 0;
@@ -340,6 +476,7 @@ text_buffer_add_char( text_buffer_t * self,
     texture_glyph_t *glyph;
     texture_glyph_t *black;
     float kerning = 0.0f;
+    size_t atlas_width, atlas_height;
 
     if( markup->font->ascender > self->line_ascender )
     {
@@ -353,14 +490,21 @@ text_buffer_add_char( text_buffer_t * self,
         self->line_descender = markup->font->descender;
     }
 
-    if( *current == '\n' )
+    if( current == '\n' )
     {
         text_buffer_finish_line(self, pen, true);
         return;
     }
 
-    glyph = texture_font_get_glyph( font, current );
-    black = texture_font_get_glyph( font, NULL );
+    atlas_width = self->manager->atlas->width;
+    atlas_height = self->manager->atlas->height;
+    glyph = texture_font_get_glyph_utf32( font, current );
+    black = texture_font_get_glyph_utf32( font, (uint32_t)-1 );
+    if( self->manager->atlas->width != atlas_width ||
+        self->manager->atlas->height != atlas_height )
+    {
+        text_buffer_rescale( self, atlas_width, atlas_height );
+    }
 
     if( glyph == NULL )
     {
@@ -369,7 +513,7 @@ text_buffer_add_char( text_buffer_t * self,
 
     if( previous && markup->font->kerning )
     {
-        kerning = texture_glyph_get_kerning( glyph, previous );
+        kerning = texture_glyph_get_kerning_utf32( glyph, previous );
     }
     pen->x += kerning;
 
@@ -390,13 +534,13 @@ text_buffer_add_char( text_buffer_t * self,
         float t1 = black->t1;
 
         SET_GLYPH_VERTEX(vertices[vcount+0],
-                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+1],
-                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+2],
-                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+3],
-                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma, black->channel );
         indices[icount + 0] = vcount+0;
         indices[icount + 1] = vcount+1;
         indices[icount + 2] = vcount+2;
@@ -424,13 +568,13 @@ text_buffer_add_char( text_buffer_t * self,
         float t1 = black->t1;
 
         SET_GLYPH_VERTEX(vertices[vcount+0],
-                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+1],
-                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+2],
-                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+3],
-                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma, black->channel );
         indices[icount + 0] = vcount+0;
         indices[icount + 1] = vcount+1;
         indices[icount + 2] = vcount+2;
@@ -457,13 +601,13 @@ text_buffer_add_char( text_buffer_t * self,
         float s1 = black->s1;
         float t1 = black->t1;
         SET_GLYPH_VERTEX(vertices[vcount+0],
-                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+1],
-                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+2],
-                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+3],
-                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma, black->channel );
         indices[icount + 0] = vcount+0;
         indices[icount + 1] = vcount+1;
         indices[icount + 2] = vcount+2;
@@ -490,13 +634,13 @@ text_buffer_add_char( text_buffer_t * self,
         float s1 = black->s1;
         float t1 = black->t1;
         SET_GLYPH_VERTEX(vertices[vcount+0],
-                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+1],
-                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+2],
-                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma, black->channel );
         SET_GLYPH_VERTEX(vertices[vcount+3],
-                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma, black->channel );
         indices[icount + 0] = vcount+0;
         indices[icount + 1] = vcount+1;
         indices[icount + 2] = vcount+2;
@@ -506,6 +650,16 @@ text_buffer_add_char( text_buffer_t * self,
         vcount += 4;
         icount += 6;
     }
+
+    // Decorations lying on another page than the glyph make an item of their own
+    if( vcount && black->page != glyph->page )
+    {
+        vertex_buffer_push_back( buffer, vertices, vcount, indices, icount );
+        vector_push_back( self->pages, &black->page );
+        vcount = 0;
+        icount = 0;
+    }
+
     {
         // Actual glyph
         float r = markup->foreground_color.red;
@@ -522,13 +676,13 @@ text_buffer_add_char( text_buffer_t * self,
         float t1 = glyph->t1;
 
         SET_GLYPH_VERTEX(vertices[vcount+0],
-                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y0,0,  s0,t0,  r,g,b,a,  x0-((int)x0), gamma, glyph->channel );
         SET_GLYPH_VERTEX(vertices[vcount+1],
-                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma );
+                         (float)(int)x0,y1,0,  s0,t1,  r,g,b,a,  x0-((int)x0), gamma, glyph->channel );
         SET_GLYPH_VERTEX(vertices[vcount+2],
-                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y1,0,  s1,t1,  r,g,b,a,  x1-((int)x1), gamma, glyph->channel );
         SET_GLYPH_VERTEX(vertices[vcount+3],
-                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma );
+                         (float)(int)x1,y0,0,  s1,t0,  r,g,b,a,  x1-((int)x1), gamma, glyph->channel );
         indices[icount + 0] = vcount+0;
         indices[icount + 1] = vcount+1;
         indices[icount + 2] = vcount+2;
@@ -539,6 +693,7 @@ text_buffer_add_char( text_buffer_t * self,
         icount += 6;
 
         vertex_buffer_push_back( buffer, vertices, vcount, indices, icount );
+        vector_push_back( self->pages, &glyph->page );
         pen->x += glyph->advance_x * (1.0f + markup->spacing);
     }
 }
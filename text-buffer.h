@@ -92,6 +92,11 @@ typedef struct  text_buffer_t {
      */
     font_manager_t *manager;
 
+    /**
+     * Atlas page used by each item of the vertex buffer
+     */
+    vector_t * pages;
+
     /**
      * Base color for text
      */
@@ -216,6 +221,11 @@ typedef struct glyph_vertex_t {
      */
     float gamma;
 
+    /**
+     * Texture channel of the glyph in a channel-packed atlas
+     */
+    float channel;
+
 } glyph_vertex_t;
 
 
@@ -297,6 +307,12 @@ typedef enum Align
 /**
  * Render a text buffer.
  *
+ * Glyphs use the texture bound to the atlas id, as set up by the
+ * application. Setting the max_pages of the font manager above 1 before
+ * getting fonts lets glyphs spill to further atlas pages instead: every page,
+ * the first one included, is then uploaded by the text buffer itself through
+ * texture_atlas_upload and drawn in one batch per page.
+ *
  * @param self a text buffer
  *
  */
@@ -344,6 +360,34 @@ typedef enum Align
                         vec2 * pen, markup_t * markup,
                         const char * current, const char * previous );
 
+ /**
+  * Add some already decoded text to the text buffer
+  *
+  * @param self       a text buffer
+  * @param pen        position of text start
+  * @param markup     Markup to be used to add text
+  * @param codepoints Characters to be added in UTF-32
+  * @param length     Number of characters to be added
+  */
+  void
+  text_buffer_add_codepoints( text_buffer_t * self,
+                              vec2 * pen, markup_t * markup,
+                              const uint32_t * codepoints, size_t length );
+
+ /**
+  * Add a char given as a UTF-32 codepoint to the text buffer
+  *
+  * @param self     a text buffer
+  * @param pen      position of text start
+  * @param markup   markup to be used to add text
+  * @param current  charactr to be added in UTF-32
+  * @param previous previous character in UTF-32, 0 if none
+  */
+  void
+  text_buffer_add_char_utf32( text_buffer_t * self,
+                              vec2 * pen, markup_t * markup,
+                              uint32_t current, uint32_t previous );
+
  /**
   * Align all the lines of text already added to the buffer
   * This alignment will be relative to the overall bounds of the
@@ -374,6 +418,17 @@ typedef enum Align
   void
   text_buffer_clear( text_buffer_t * self );
 
+/**
+  * Reserve room for a number of glyphs so that adding them does not
+  * reallocate the underlying vertex buffer. Each glyph needs four vertices,
+  * six indices and one item (decorations such as underline need more).
+  *
+  * @param self   a text buffer
+  * @param length number of glyphs to make room for
+ */
+  void
+  text_buffer_reserve( text_buffer_t * self, size_t length );
+
 
 /** @} */
 
@@ -0,0 +1,181 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "opengl.h"
+#include "texture-atlas.h"
+
+
+// ----------------------------------------------- texture_atlas_interleave ---
+/* Gathers a region of the four planes of a channel-packed atlas into RGBA
+ * texels, reallocating the given buffer to fit */
+static unsigned char *
+texture_atlas_interleave( const texture_atlas_t * self,
+                          const ivec4 * rect,
+                          unsigned char * texels )
+{
+    const unsigned char *planes[4];
+    unsigned char *texel;
+    size_t i, x, y, offset;
+
+    texels = (unsigned char *) realloc( texels, rect->width * rect->height * 4 );
+    if( texels == NULL )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    planes[0] = self->data;
+    for( i = 0; i < 3; ++i )
+    {
+        planes[i+1] = self->planes[i]->data;
+    }
+    texel = texels;
+    for( y = rect->y; y < (size_t)(rect->y + rect->height); ++y )
+    {
+        offset = y * self->width + rect->x;
+        for( x = 0; x < (size_t)rect->width; ++x, texel += 4 )
+        {
+            texel[0] = planes[0][offset + x];
+            texel[1] = planes[1][offset + x];
+            texel[2] = planes[2][offset + x];
+            texel[3] = planes[3][offset + x];
+        }
+    }
+    return texels;
+}
+
+
+// --------------------------------------------------- texture_atlas_upload ---
+void
+texture_atlas_upload( texture_atlas_t * self )
+{
+    GLint alignment;
+    ivec4 *rect;
+    size_t i, j;
+    unsigned char *texels = NULL;
+#if defined(GL_RED)
+    GLenum format = self->depth == 1 ? GL_RED :
+                    self->depth == 3 ? GL_RGB : GL_RGBA;
+#else
+    GLenum format = self->depth == 1 ? GL_LUMINANCE :
+                    self->depth == 3 ? GL_RGB : GL_RGBA;
+#endif
+
+    assert( self );
+    assert( self->data );
+
+    if( self->channels > 1 )
+    {
+        // Planes are interleaved into an RGBA texture, one region at a time
+        format = GL_RGBA;
+        for( i = 0; i < 3; ++i )
+        {
+            for( j = 0; j < self->planes[i]->dirty->size; ++j )
+            {
+                rect = (ivec4 *) vector_get( self->planes[i]->dirty, j );
+                texture_atlas_mark_dirty( self, rect->x, rect->y,
+                                          rect->width, rect->height );
+            }
+            vector_clear( self->planes[i]->dirty );
+        }
+    }
+
+    if( !self->id )
+    {
+        glGenTextures( 1, &self->id );
+        glBindTexture( GL_TEXTURE_2D, self->id );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+
+        // A new texture has no storage yet
+        vector_clear( self->dirty );
+        texture_atlas_mark_dirty( self, 0, 0, self->width, self->height );
+    }
+    else
+    {
+        glBindTexture( GL_TEXTURE_2D, self->id );
+    }
+    if( !self->dirty->size )
+    {
+        return;
+    }
+
+    glGetIntegerv( GL_UNPACK_ALIGNMENT, &alignment );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    for( i = 0; i < self->dirty->size; ++i )
+    {
+        rect = (ivec4 *) vector_get( self->dirty, i );
+        if( self->channels > 1 )
+        {
+            texels = texture_atlas_interleave( self, rect, texels );
+            if( (size_t)rect->width == self->width && (size_t)rect->height == self->height )
+            {
+                glTexImage2D( GL_TEXTURE_2D, 0, format, self->width, self->height,
+                              0, format, GL_UNSIGNED_BYTE, texels );
+            }
+            else
+            {
+                glTexSubImage2D( GL_TEXTURE_2D, 0, rect->x, rect->y,
+                                 rect->width, rect->height, format,
+                                 GL_UNSIGNED_BYTE, texels );
+            }
+            continue;
+        }
+        if( (size_t)rect->width == self->width && (size_t)rect->height == self->height )
+        {
+            glTexImage2D( GL_TEXTURE_2D, 0, format, self->width, self->height,
+                          0, format, GL_UNSIGNED_BYTE, self->data );
+            continue;
+        }
+#if defined(GL_UNPACK_ROW_LENGTH)
+        glPixelStorei( GL_UNPACK_ROW_LENGTH, self->width );
+        glTexSubImage2D( GL_TEXTURE_2D, 0, rect->x, rect->y,
+                         rect->width, rect->height, format, GL_UNSIGNED_BYTE,
+                         self->data + (rect->y*self->width + rect->x) * self->depth );
+        glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+#else
+        // Whole rows are sent when the row length cannot be set
+        glTexSubImage2D( GL_TEXTURE_2D, 0, 0, rect->y,
+                         self->width, rect->height, format, GL_UNSIGNED_BYTE,
+                         self->data + rect->y*self->width * self->depth );
+#endif
+    }
+    glPixelStorei( GL_UNPACK_ALIGNMENT, alignment );
+    vector_clear( self->dirty );
+    free( texels );
+}
@@ -39,17 +39,692 @@
 #include "texture-atlas.h"
 
 
+// ----------------------------------------------- texture_atlas_clear_tree ---
+/* Empties the segment tree of the skyline nodes */
+static void
+texture_atlas_clear_tree( texture_atlas_t * self )
+{
+    size_t i;
+
+    for( i = 0; i < 2 * self->leaves; ++i )
+    {
+        self->tree[i].x = INT_MAX;
+        self->tree[i].y = 0;
+        self->tree[i].z = INT_MAX;
+        self->tree[i].w = INT_MAX;
+        self->bounds[i].x = 0;
+        self->bounds[i].y = INT_MAX;
+    }
+}
+
+
+// ------------------------------------------------ texture_atlas_set_bound ---
+/* Refreshes the height regions wider than the skyline node starting at
+ * column x rest at least at, which depends on the height of the next node. */
+static void
+texture_atlas_set_bound( texture_atlas_t * self,
+                         const int x )
+{
+    ivec2 *bounds = self->bounds;
+    const ivec3 *nodes = self->nodes;
+    size_t i = self->leaves + x;
+    int next = x + nodes[x].z;
+
+    if( nodes[x].z > 0 )
+    {
+        bounds[i].x = nodes[x].z;
+        bounds[i].y = nodes[x].y;
+        if( next < (int)self->width - 1 && nodes[next].z > 0 &&
+            nodes[next].y > bounds[i].y )
+        {
+            bounds[i].y = nodes[next].y;
+        }
+    }
+    else
+    {
+        bounds[i].x = 0;
+        bounds[i].y = INT_MAX;
+    }
+    for( i /= 2; i > 0; i /= 2 )
+    {
+        const ivec2 *left = bounds + 2*i, *right = bounds + 2*i + 1;
+        bounds[i].x = left->x > right->x ? left->x : right->x;
+        bounds[i].y = left->y < right->y ? left->y : right->y;
+    }
+}
+
+
+// ------------------------------------------------- texture_atlas_set_node ---
+/* Stores the skyline node starting at column x (a zero width removes it) and
+ * refreshes the segment tree above it. */
+static void
+texture_atlas_set_node( texture_atlas_t * self,
+                        const int x,
+                        const int y,
+                        const int width )
+{
+    ivec4 *tree = self->tree;
+    size_t i = self->leaves + x;
+
+    self->nodes[x].y = y;
+    self->nodes[x].z = width;
+    if( width > 0 )
+    {
+        tree[i].x = y;
+        tree[i].y = y;
+        tree[i].z = width;
+        tree[i].w = x;
+    }
+    else
+    {
+        tree[i].x = INT_MAX;
+        tree[i].y = 0;
+        tree[i].z = INT_MAX;
+        tree[i].w = INT_MAX;
+    }
+    for( i /= 2; i > 0; i /= 2 )
+    {
+        const ivec4 *left = tree + 2*i, *right = tree + 2*i + 1;
+        tree[i].x = left->x < right->x ? left->x : right->x;
+        tree[i].y = left->y > right->y ? left->y : right->y;
+        tree[i].z = left->z < right->z ? left->z : right->z;
+        tree[i].w = left->w < right->w ? left->w : right->w;
+    }
+    texture_atlas_set_bound( self, x );
+}
+
+
+// ----------------------------------------------- texture_atlas_mark_dirty ---
+/* Records a modified region, merged with the pending ones whenever their
+ * bounding box carries no more than dirty_slack unmodified pixels. */
+void
+texture_atlas_mark_dirty( texture_atlas_t * self,
+                          int x, int y, int width, int height )
+{
+    vector_t *dirty = self->dirty;
+    ivec4 *rect, merged;
+    size_t i;
+    int left, top, right, bottom, overlap;
+
+    if( width <= 0 || height <= 0 )
+    {
+        return;
+    }
+    for( i = 0; i < dirty->size; )
+    {
+        rect = (ivec4 *) vector_get( dirty, i );
+        left = x > rect->x ? x : rect->x;
+        top = y > rect->y ? y : rect->y;
+        right = x + width < rect->x + rect->width ? x + width : rect->x + rect->width;
+        bottom = y + height < rect->y + rect->height ? y + height : rect->y + rect->height;
+        overlap = right > left && bottom > top ? (right - left) * (bottom - top) : 0;
+
+        merged.x = x < rect->x ? x : rect->x;
+        merged.y = y < rect->y ? y : rect->y;
+        right = x + width > rect->x + rect->width ? x + width : rect->x + rect->width;
+        bottom = y + height > rect->y + rect->height ? y + height : rect->y + rect->height;
+        merged.width = right - merged.x;
+        merged.height = bottom - merged.y;
+
+        if( (size_t)(merged.width * merged.height - width * height
+                     - rect->width * rect->height + overlap) > self->dirty_slack )
+        {
+            ++i;
+            continue;
+        }
+
+        // Merge and start over, the grown region may now absorb others
+        x = merged.x;
+        y = merged.y;
+        width = merged.width;
+        height = merged.height;
+        *rect = *(ivec4 *) vector_back( dirty );
+        vector_pop_back( dirty );
+        i = 0;
+    }
+    merged.x = x;
+    merged.y = y;
+    merged.width = width;
+    merged.height = height;
+    vector_push_back( dirty, &merged );
+}
+
+
+// ---------------------------------------------------- texture_atlas_reset ---
+/* Empties the packer down to a single free area spanning the whole atlas */
+static void
+texture_atlas_reset( texture_atlas_t * self )
+{
+    // We want a one pixel border around the whole atlas to avoid any artefact when
+    // sampling texture
+    ivec4 area = {{1, 1, self->width-2, self->height-2}};
+
+    self->used = 0;
+    vector_clear( self->free_rects );
+    switch( self->packer )
+    {
+    case PACKER_SKYLINE:
+        memset( self->nodes, 0, self->width * sizeof(ivec3) );
+        texture_atlas_clear_tree( self );
+        texture_atlas_set_node( self, area.x, area.y, area.width );
+        break;
+
+    case PACKER_MAXRECTS:
+    case PACKER_GUILLOTINE:
+        vector_push_back( self->free_rects, &area );
+        break;
+
+    case PACKER_SHELF:
+        vector_clear( self->shelves );
+        break;
+    }
+}
+
+
+// ------------------------------------------------------ texture_atlas_top ---
+/* Returns the height of the highest node starting in columns [first,last) */
+static int
+texture_atlas_top( const texture_atlas_t * self,
+                   size_t first,
+                   size_t last )
+{
+    const ivec4 *tree = self->tree;
+    int y = 0;
+
+    for( first += self->leaves, last += self->leaves;
+         first < last; first /= 2, last /= 2 )
+    {
+        if( first & 1 )
+        {
+            y = tree[first].y > y ? tree[first].y : y;
+            ++first;
+        }
+        if( last & 1 )
+        {
+            --last;
+            y = tree[last].y > y ? tree[last].y : y;
+        }
+    }
+    return y;
+}
+
+
+// ------------------------------------------------------ texture_atlas_fit ---
+/* Returns the height a region of the given size would sit at when its left
+ * edge is put on the skyline node starting at column x, or -1 if it does
+ * not fit there. */
+static int
+texture_atlas_fit( const texture_atlas_t * self,
+                   const int x,
+                   const size_t width,
+                   const size_t height )
+{
+    int y;
+
+    if( (x + width) > (self->width-1) )
+    {
+        return -1;
+    }
+    if( width == 0 )
+    {
+        return self->nodes[x].y;
+    }
+
+    // The region rests on the highest node starting below it
+    y = texture_atlas_top( self, x, x + width );
+    if( (y + height) > (self->height-1) )
+    {
+        return -1;
+    }
+    return y;
+}
+
+
+// --------------------------------------------------- texture_atlas_better ---
+/* Compares a fit against the best one found so far: the lowest region top
+ * wins, then the narrowest node, then the leftmost one. */
+static int
+texture_atlas_better( const size_t bottom,
+                      const size_t width,
+                      const size_t x,
+                      const size_t best[3] )
+{
+    if( bottom != best[0] )
+    {
+        return bottom < best[0];
+    }
+    if( width != best[1] )
+    {
+        return width < best[1];
+    }
+    return x < best[2];
+}
+
+
+// ----------------------------------------------------- texture_atlas_best ---
+/* Searches the subtree at index, covering count columns from first, for a
+ * better fit than best. Subtrees are visited lowest first and skipped as soon
+ * as the lowest a region can rest there cannot beat the best fit found so
+ * far: on their lowest node, or on the higher of a node and the next one
+ * when the region is wider than all their nodes. */
+static void
+texture_atlas_best( const texture_atlas_t * self,
+                    const size_t index,
+                    const size_t first,
+                    const size_t count,
+                    const size_t width,
+                    const size_t height,
+                    size_t best[3] )
+{
+    const ivec4 *tree = self->tree;
+    const ivec4 *node = tree + index;
+    size_t bottom;
+    int y;
+
+    if( node->w == INT_MAX || node->w + width > self->width-1 )
+    {
+        return;
+    }
+    bottom = node->x + height;
+    if( (int)width > self->bounds[index].x )
+    {
+        bottom = self->bounds[index].y + height;
+    }
+    if( !texture_atlas_better( bottom, node->z, node->w, best ) )
+    {
+        return;
+    }
+
+    // A single node starts within this subtree when the leftmost one
+    // reaches its end
+    if( node->w + self->nodes[node->w].z >= (int)(first + count) )
+    {
+        y = texture_atlas_fit( self, node->w, width, height );
+        bottom = y + height;
+        if( y >= 0 && texture_atlas_better( bottom, node->z, node->w, best ) )
+        {
+            best[0] = bottom;
+            best[1] = node->z;
+            best[2] = node->w;
+        }
+        return;
+    }
+
+    if( tree[2*index+1].x < tree[2*index].x )
+    {
+        texture_atlas_best( self, 2*index+1, first + count/2, count/2, width, height, best );
+        texture_atlas_best( self, 2*index, first, count/2, width, height, best );
+    }
+    else
+    {
+        texture_atlas_best( self, 2*index, first, count/2, width, height, best );
+        texture_atlas_best( self, 2*index+1, first + count/2, count/2, width, height, best );
+    }
+}
+
+
+// ------------------------------------------- texture_atlas_skyline_region ---
+/* Skyline bottom-left: the region goes where its top ends up lowest */
+static ivec4
+texture_atlas_skyline_region( texture_atlas_t * self,
+                              const size_t width,
+                              const size_t height )
+{
+    ivec3 *nodes;
+    ivec4 region = {{0,0,width,height}};
+    size_t best[3] = { UINT_MAX, 0, 0 };
+    int x, y, end, top, last, next;
+
+    // Regions must end below the atlas border, which bounds the search
+    if( width > 0 )
+    {
+        best[0] = self->height;
+    }
+    texture_atlas_best( self, 1, 0, self->leaves, width, height, best );
+    if( best[1] == 0 )
+    {
+        region.x = -1;
+        region.y = -1;
+        region.width = 0;
+        region.height = 0;
+        return region;
+    }
+
+    nodes = self->nodes;
+    region.x = x = best[2];
+    region.y = y = best[0] - height;
+    if( width == 0 )
+    {
+        return region;
+    }
+
+    // Drop the nodes now covered by the region and cut the last one short
+    top = y + height;
+    end = x + width;
+    last = self->width - 1;
+    for( next = x; next < end; )
+    {
+        int node = next;
+        y = nodes[node].y;
+        next += nodes[node].z;
+        if( node != x )
+        {
+            texture_atlas_set_node( self, node, 0, 0 );
+        }
+    }
+    if( next > end )
+    {
+        texture_atlas_set_node( self, end, y, next - end );
+        if( next < last )
+        {
+            nodes[next].x = end;
+        }
+    }
+    if( end < last )
+    {
+        nodes[end].x = x;
+    }
+    texture_atlas_set_node( self, x, top, width );
+
+    // Merge with neighbours of the same height
+    if( end < last && nodes[end].y == top )
+    {
+        next = end + nodes[end].z;
+        texture_atlas_set_node( self, x, top, width + nodes[end].z );
+        texture_atlas_set_node( self, end, 0, 0 );
+        if( next < last )
+        {
+            nodes[next].x = x;
+        }
+    }
+    if( x > 1 && nodes[nodes[x].x].y == top )
+    {
+        int prev = nodes[x].x;
+        next = x + nodes[x].z;
+        texture_atlas_set_node( self, prev, top, nodes[prev].z + nodes[x].z );
+        texture_atlas_set_node( self, x, 0, 0 );
+        if( next < last )
+        {
+            nodes[next].x = prev;
+        }
+        x = prev;
+    }
+
+    // The node before now ends next to a different height
+    texture_atlas_set_bound( self, x );
+    if( x > 1 )
+    {
+        texture_atlas_set_bound( self, nodes[x].x );
+    }
+    return region;
+}
+
+
+// ------------------------------------------------- texture_atlas_contains ---
+/* Tells whether rectangle a contains rectangle b */
+static int
+texture_atlas_contains( const ivec4 * a,
+                        const ivec4 * b )
+{
+    return b->x >= a->x && b->y >= a->y &&
+           b->x + b->width <= a->x + a->width &&
+           b->y + b->height <= a->y + a->height;
+}
+
+
+// ------------------------------------------ texture_atlas_maxrects_region ---
+/* MaxRects best short side fit: free rectangles are kept maximal and may
+ * overlap, the region goes in the one leaving the shortest side over */
+static ivec4
+texture_atlas_maxrects_region( texture_atlas_t * self,
+                               const size_t width,
+                               const size_t height )
+{
+    vector_t *rects = self->free_rects;
+    ivec4 *rect, *other;
+    ivec4 region = {{-1,-1,0,0}};
+    int best_short = INT_MAX, best_long = INT_MAX;
+    size_t i, j, count, kept;
+
+    for( i = 0; i < rects->size; ++i )
+    {
+        rect = (ivec4 *) vector_get( rects, i );
+        if( (size_t)rect->width >= width && (size_t)rect->height >= height )
+        {
+            int dw = rect->width - width, dh = rect->height - height;
+            int shorter = dw < dh ? dw : dh, longer = dw < dh ? dh : dw;
+            if( shorter < best_short ||
+                (shorter == best_short && longer < best_long) )
+            {
+                best_short = shorter;
+                best_long = longer;
+                region.x = rect->x;
+                region.y = rect->y;
+            }
+        }
+    }
+    if( region.x < 0 )
+    {
+        return region;
+    }
+    region.width = width;
+    region.height = height;
+
+    // Split every free rectangle overlapping the region into the (up to
+    // four) maximal rectangles around it, appended after the others
+    count = rects->size;
+    for( i = 0; i < count; ++i )
+    {
+        ivec4 piece, split = *(ivec4 *) vector_get( rects, i );
+
+        if( region.x >= split.x + split.width || region.x + region.width <= split.x ||
+            region.y >= split.y + split.height || region.y + region.height <= split.y )
+        {
+            continue;
+        }
+        if( region.x > split.x )
+        {
+            piece = split;
+            piece.width = region.x - split.x;
+            vector_push_back( rects, &piece );
+        }
+        if( region.x + region.width < split.x + split.width )
+        {
+            piece = split;
+            piece.x = region.x + region.width;
+            piece.width = split.x + split.width - piece.x;
+            vector_push_back( rects, &piece );
+        }
+        if( region.y > split.y )
+        {
+            piece = split;
+            piece.height = region.y - split.y;
+            vector_push_back( rects, &piece );
+        }
+        if( region.y + region.height < split.y + split.height )
+        {
+            piece = split;
+            piece.y = region.y + region.height;
+            piece.height = split.y + split.height - piece.y;
+            vector_push_back( rects, &piece );
+        }
+        ((ivec4 *) vector_get( rects, i ))->width = 0;
+    }
+
+    // Drop split rectangles along with new ones lying inside another free
+    // rectangle. Untouched ones cannot lie inside each other or inside a
+    // piece, which comes from a rectangle none of them was inside.
+    for( i = count; i < rects->size; ++i )
+    {
+        rect = (ivec4 *) vector_get( rects, i );
+        for( j = 0; j < rects->size && rect->width; ++j )
+        {
+            other = (ivec4 *) vector_get( rects, j );
+            if( j != i && other->width && texture_atlas_contains( other, rect ) &&
+                (j < count || !texture_atlas_contains( rect, other ) || j < i) )
+            {
+                rect->width = 0;
+            }
+        }
+    }
+    for( i = kept = 0; i < rects->size; ++i )
+    {
+        rect = (ivec4 *) vector_get( rects, i );
+        if( rect->width )
+        {
+            *(ivec4 *) vector_get( rects, kept++ ) = *rect;
+        }
+    }
+    rects->size = kept;
+
+    return region;
+}
+
+
+// ---------------------------------------- texture_atlas_guillotine_region ---
+/* Guillotine best area fit: free rectangles are disjoint, the region goes in
+ * the smallest one and what remains is cut along the shorter leftover axis */
+static ivec4
+texture_atlas_guillotine_region( texture_atlas_t * self,
+                                 const size_t width,
+                                 const size_t height )
+{
+    vector_t *rects = self->free_rects;
+    ivec4 *rect;
+    ivec4 bottom, right, region = {{-1,-1,0,0}};
+    size_t i, best_index = 0, best_area = (size_t) -1;
+
+    for( i = 0; i < rects->size; ++i )
+    {
+        rect = (ivec4 *) vector_get( rects, i );
+        if( (size_t)rect->width >= width && (size_t)rect->height >= height &&
+            (size_t)rect->width * rect->height < best_area )
+        {
+            best_area = (size_t)rect->width * rect->height;
+            best_index = i;
+        }
+    }
+    if( best_area == (size_t) -1 )
+    {
+        return region;
+    }
+
+    rect = (ivec4 *) vector_get( rects, best_index );
+    region.x = rect->x;
+    region.y = rect->y;
+    region.width = width;
+    region.height = height;
+
+    bottom = right = *rect;
+    bottom.y += height;
+    bottom.height -= height;
+    right.x += width;
+    right.width -= width;
+    if( rect->width - width <= rect->height - height )
+    {
+        // Horizontal cut: the right piece only spans the region height
+        right.height = height;
+    }
+    else
+    {
+        // Vertical cut: the bottom piece only spans the region width
+        bottom.width = width;
+    }
+
+    // Reuse the split rectangle's slot, moving the last one in if both
+    // pieces are empty
+    if( bottom.width > 0 && bottom.height > 0 )
+    {
+        *rect = bottom;
+        if( right.width > 0 && right.height > 0 )
+        {
+            vector_push_back( rects, &right );
+        }
+    }
+    else if( right.width > 0 && right.height > 0 )
+    {
+        *rect = right;
+    }
+    else
+    {
+        *rect = *(ivec4 *) vector_back( rects );
+        vector_pop_back( rects );
+    }
+
+    return region;
+}
+
+
+// --------------------------------------------- texture_atlas_shelf_region ---
+/* Shelf first fit: the region goes on the first shelf tall enough with room
+ * left, or on a new shelf as tall as the region on top of the last one */
+static ivec4
+texture_atlas_shelf_region( texture_atlas_t * self,
+                            const size_t width,
+                            const size_t height )
+{
+    vector_t *shelves = self->shelves;
+    ivec3 *shelf;
+    ivec3 next = {{1, height, 1}};
+    ivec4 region = {{-1,-1,0,0}};
+    size_t i;
+
+    if( width > self->width-2 )
+    {
+        return region;
+    }
+    for( i = 0; i < shelves->size; ++i )
+    {
+        shelf = (ivec3 *) vector_get( shelves, i );
+        if( (size_t)shelf->y >= height && shelf->z + width <= self->width-1 )
+        {
+            region.x = shelf->z;
+            region.y = shelf->x;
+            region.width = width;
+            region.height = height;
+            shelf->z += width;
+            return region;
+        }
+    }
+
+    if( shelves->size )
+    {
+        shelf = (ivec3 *) vector_back( shelves );
+        next.x = shelf->x + shelf->y;
+    }
+    if( next.x + height > self->height-1 )
+    {
+        return region;
+    }
+    region.x = next.z;
+    region.y = next.x;
+    region.width = width;
+    region.height = height;
+    next.z += width;
+    vector_push_back( shelves, &next );
+
+    return region;
+}
+
+
 // ------------------------------------------------------ texture_atlas_new ---
 texture_atlas_t *
 texture_atlas_new( const size_t width,
                    const size_t height,
                    const size_t depth )
 {
-    texture_atlas_t *self = (texture_atlas_t *) malloc( sizeof(texture_atlas_t) );
+    return texture_atlas_new_with_packer( width, height, depth, PACKER_SKYLINE );
+}
 
-    // We want a one pixel border around the whole atlas to avoid any artefact when
-    // sampling texture
-    ivec3 node = {{1,1,width-2}};
+
+// ------------------------------------------ texture_atlas_new_with_packer ---
+texture_atlas_t *
+texture_atlas_new_with_packer( const size_t width,
+                               const size_t height,
+                               const size_t depth,
+                               const texture_atlas_packer_t packer )
+{
+    texture_atlas_t *self = (texture_atlas_t *) malloc( sizeof(texture_atlas_t) );
 
     assert( (depth == 1) || (depth == 3) || (depth == 4) );
     if( self == NULL)
@@ -58,24 +733,80 @@ texture_atlas_new( const size_t width,
                  "line %d: No more memory for allocating data\n", __LINE__ );
         exit( EXIT_FAILURE );
     }
-    self->nodes = vector_new( sizeof(ivec3) );
     self->used = 0;
     self->width = width;
     self->height = height;
     self->depth = depth;
     self->id = 0;
+    self->packer = packer;
+    self->nodes = NULL;
+    self->tree = NULL;
+    self->bounds = NULL;
+    self->leaves = 0;
+    self->free_rects = vector_new( sizeof(ivec4) );
+    self->shelves = NULL;
+    self->next = NULL;
+    self->max_width = width;
+    self->max_height = height;
+    self->dirty = vector_new( sizeof(ivec4) );
+    self->dirty_slack = 4096;
+    self->channels = 1;
+    self->planes[0] = self->planes[1] = self->planes[2] = NULL;
+    self->fonts = vector_new( sizeof(void *) );
 
-    vector_push_back( self->nodes, &node );
+    switch( packer )
+    {
+    case PACKER_SKYLINE:
+        self->leaves = 1;
+        while( self->leaves < width )
+        {
+            self->leaves *= 2;
+        }
+        self->nodes = (ivec3 *) calloc( width, sizeof(ivec3) );
+        self->tree = (ivec4 *) malloc( 2 * self->leaves * sizeof(ivec4) );
+        self->bounds = (ivec2 *) malloc( 2 * self->leaves * sizeof(ivec2) );
+        break;
+
+    case PACKER_MAXRECTS:
+    case PACKER_GUILLOTINE:
+        break;
+
+    case PACKER_SHELF:
+        self->shelves = vector_new( sizeof(ivec3) );
+        break;
+    }
     self->data = (unsigned char *)
         calloc( width*height*depth, sizeof(unsigned char) );
 
-    if( self->data == NULL)
+    if( (packer == PACKER_SKYLINE && (self->nodes == NULL || self->tree == NULL ||
+                                     self->bounds == NULL)) ||
+        self->data == NULL)
     {
         fprintf( stderr,
                  "line %d: No more memory for allocating data\n", __LINE__ );
         exit( EXIT_FAILURE );
     }
+    texture_atlas_reset( self );
+    texture_atlas_mark_dirty( self, 0, 0, width, height );
+
+    return self;
+}
 
+
+// ------------------------------------ texture_atlas_new_channel_packed ---
+texture_atlas_t *
+texture_atlas_new_channel_packed( const size_t width,
+                                  const size_t height,
+                                  const texture_atlas_packer_t packer )
+{
+    texture_atlas_t *self = texture_atlas_new_with_packer( width, height, 1, packer );
+    size_t i;
+
+    self->channels = 4;
+    for( i = 0; i < 3; ++i )
+    {
+        self->planes[i] = texture_atlas_new_with_packer( width, height, 1, packer );
+    }
     return self;
 }
 
@@ -84,12 +815,34 @@ texture_atlas_new( const size_t width,
 void
 texture_atlas_delete( texture_atlas_t *self )
 {
+    size_t i;
+
     assert( self );
-    vector_delete( self->nodes );
+    free( self->nodes );
+    free( self->tree );
+    free( self->bounds );
+    vector_delete( self->free_rects );
+    vector_delete( self->dirty );
+    vector_delete( self->fonts );
+    for( i = 0; i < 3; ++i )
+    {
+        if( self->planes[i] )
+        {
+            texture_atlas_delete( self->planes[i] );
+        }
+    }
+    if( self->shelves )
+    {
+        vector_delete( self->shelves );
+    }
     if( self->data )
     {
         free( self->data );
     }
+    if( self->next )
+    {
+        texture_atlas_delete( self->next );
+    }
     free( self );
 }
 
@@ -123,177 +876,388 @@ texture_atlas_set_region( texture_atlas_t * self,
         memcpy( self->data+((y+i)*self->width + x ) * charsize * depth,
                 data + (i*stride) * charsize, width * charsize * depth  );
     }
+    texture_atlas_mark_dirty( self, x, y, width, height );
 }
 
 
-// ------------------------------------------------------ texture_atlas_fit ---
-int
-texture_atlas_fit( texture_atlas_t * self,
-                   const size_t index,
-                   const size_t width,
-                   const size_t height )
+// ----------------------------------------------- texture_atlas_get_region ---
+ivec4
+texture_atlas_get_region( texture_atlas_t * self,
+                          const size_t width,
+                          const size_t height )
 {
-    ivec3 *node;
-    int x, y, width_left;
-	size_t i;
+    ivec4 region = {{-1,-1,0,0}};
 
     assert( self );
 
-    node = (ivec3 *) (vector_get( self->nodes, index ));
-    x = node->x;
-	y = node->y;
-    width_left = width;
-	i = index;
+    // Skyline and shelf packers cannot give space back, regions freed from
+    // them are tracked as free rectangles and reused first
+    if( (self->packer == PACKER_SKYLINE || self->packer == PACKER_SHELF) &&
+        self->free_rects->size )
+    {
+        region = texture_atlas_guillotine_region( self, width, height );
+        if( region.x >= 0 )
+        {
+            self->used += width * height;
+            return region;
+        }
+    }
+
+    switch( self->packer )
+    {
+    case PACKER_SKYLINE:
+        region = texture_atlas_skyline_region( self, width, height );
+        break;
+    case PACKER_MAXRECTS:
+        region = texture_atlas_maxrects_region( self, width, height );
+        break;
+    case PACKER_GUILLOTINE:
+        region = texture_atlas_guillotine_region( self, width, height );
+        break;
+    case PACKER_SHELF:
+        region = texture_atlas_shelf_region( self, width, height );
+        break;
+    }
+    if( region.x >= 0 )
+    {
+        self->used += width * height;
+    }
+    return region;
+}
+
 
-	if ( (x + width) > (self->width-1) )
+// ---------------------------------------------- texture_atlas_free_region ---
+void
+texture_atlas_free_region( texture_atlas_t * self,
+                           const ivec4 region )
+{
+    vector_t *rects;
+    ivec4 merged = region;
+    ivec4 *rect;
+    size_t i;
+
+    assert( self );
+    assert( region.x > 0 );
+    assert( region.y > 0 );
+    assert( (size_t)(region.x + region.width) <= (self->width-1) );
+    assert( (size_t)(region.y + region.height) <= (self->height-1) );
+
+    if( region.width <= 0 || region.height <= 0 )
+    {
+        return;
+    }
+    for( i = 0; i < (size_t)region.height; ++i )
     {
-		return -1;
+        memset( self->data + ((region.y+i)*self->width + region.x) * self->depth,
+                0, region.width * self->depth );
     }
-	y = node->y;
-	while( width_left > 0 )
-	{
-        node = (ivec3 *) (vector_get( self->nodes, i ));
-        if( node->y > y )
+    texture_atlas_mark_dirty( self, region.x, region.y,
+                              region.width, region.height );
+    self->used -= region.width * region.height;
+    if( self->used == 0 )
+    {
+        texture_atlas_reset( self );
+        return;
+    }
+
+    // Coalesce with every free rectangle sharing a whole edge, starting over
+    // after each merge since the grown rectangle may now line up with others
+    rects = self->free_rects;
+    for( i = 0; i < rects->size; )
+    {
+        rect = (ivec4 *) vector_get( rects, i );
+        if( texture_atlas_contains( rect, &merged ) )
         {
-            y = node->y;
+            return;
         }
-		if( (y + height) > (self->height-1) )
+        if( texture_atlas_contains( &merged, rect ) ||
+            (rect->x == merged.x && rect->width == merged.width &&
+             (rect->y + rect->height == merged.y || merged.y + merged.height == rect->y)) ||
+            (rect->y == merged.y && rect->height == merged.height &&
+             (rect->x + rect->width == merged.x || merged.x + merged.width == rect->x)) )
         {
-			return -1;
+            int right = merged.x + merged.width, bottom = merged.y + merged.height;
+            right = right > rect->x + rect->width ? right : rect->x + rect->width;
+            bottom = bottom > rect->y + rect->height ? bottom : rect->y + rect->height;
+            merged.x = merged.x < rect->x ? merged.x : rect->x;
+            merged.y = merged.y < rect->y ? merged.y : rect->y;
+            merged.width = right - merged.x;
+            merged.height = bottom - merged.y;
+
+            *rect = *(ivec4 *) vector_back( rects );
+            vector_pop_back( rects );
+            i = 0;
+            continue;
         }
-		width_left -= node->z;
-		++i;
-	}
-	return y;
+        ++i;
+    }
+    vector_push_back( rects, &merged );
 }
 
 
-// ---------------------------------------------------- texture_atlas_merge ---
+// ---------------------------------------------------- texture_atlas_clear ---
 void
-texture_atlas_merge( texture_atlas_t * self )
+texture_atlas_clear( texture_atlas_t * self )
 {
-    ivec3 *node, *next;
     size_t i;
 
     assert( self );
+    assert( self->data );
 
-	for( i=0; i< self->nodes->size-1; ++i )
+    texture_atlas_reset( self );
+    memset( self->data, 0, self->width*self->height*self->depth );
+    texture_atlas_mark_dirty( self, 0, 0, self->width, self->height );
+    for( i = 0; i < 3; ++i )
+    {
+        if( self->planes[i] )
+        {
+            texture_atlas_clear( self->planes[i] );
+        }
+    }
+    if( self->next )
     {
-        node = (ivec3 *) (vector_get( self->nodes, i ));
-        next = (ivec3 *) (vector_get( self->nodes, i+1 ));
-		if( node->y == next->y )
-		{
-			node->z += next->z;
-            vector_erase( self->nodes, i+1 );
-			--i;
-		}
+        texture_atlas_clear( self->next );
     }
 }
 
 
-// ----------------------------------------------- texture_atlas_get_region ---
-ivec4
-texture_atlas_get_region( texture_atlas_t * self,
-                          const size_t width,
-                          const size_t height )
+// ----------------------------------------------------- texture_atlas_swap ---
+void
+texture_atlas_swap( texture_atlas_t * self,
+                    texture_atlas_t * other )
+{
+    texture_atlas_t tmp;
+
+    assert( self && other );
+    assert( self->width == other->width && self->height == other->height );
+    assert( self->depth == other->depth && self->packer == other->packer );
+
+    tmp = *self;
+    self->nodes = other->nodes;
+    self->tree = other->tree;
+    self->bounds = other->bounds;
+    self->leaves = other->leaves;
+    self->free_rects = other->free_rects;
+    self->shelves = other->shelves;
+    self->used = other->used;
+    self->data = other->data;
+    other->nodes = tmp.nodes;
+    other->tree = tmp.tree;
+    other->bounds = tmp.bounds;
+    other->leaves = tmp.leaves;
+    other->free_rects = tmp.free_rects;
+    other->shelves = tmp.shelves;
+    other->used = tmp.used;
+    other->data = tmp.data;
+
+    vector_clear( self->dirty );
+    texture_atlas_mark_dirty( self, 0, 0, self->width, self->height );
+    vector_clear( other->dirty );
+    texture_atlas_mark_dirty( other, 0, 0, other->width, other->height );
+}
+
+
+// ---------------------------------------------- texture_atlas_get_channel ---
+texture_atlas_t *
+texture_atlas_get_channel( texture_atlas_t * self,
+                           const size_t channel )
+{
+    assert( self );
+
+    if( channel >= self->channels )
+    {
+        return NULL;
+    }
+    return channel ? self->planes[channel-1] : self;
+}
+
+
+// ------------------------------------------------- texture_atlas_get_page ---
+texture_atlas_t *
+texture_atlas_get_page( texture_atlas_t * self,
+                        const size_t page )
 {
-	int y, best_index;
-    size_t best_height, best_width;
-    ivec3 *node, *prev;
-    ivec4 region = {{0,0,width,height}};
     size_t i;
 
     assert( self );
 
-    best_height = UINT_MAX;
-    best_index  = -1;
-    best_width = UINT_MAX;
-	for( i=0; i<self->nodes->size; ++i )
-	{
-        y = texture_atlas_fit( self, i, width, height );
-		if( y >= 0 )
-		{
-            node = (ivec3 *) vector_get( self->nodes, i );
-			if( ( (y + height) < best_height ) ||
-                ( ((y + height) == best_height) && (node->z > 0 && (size_t)node->z < best_width)) )
-			{
-				best_height = y + height;
-				best_index = i;
-				best_width = node->z;
-				region.x = node->x;
-				region.y = y;
-			}
-        }
-    }
-
-	if( best_index == -1 )
+    for( i = 0; self && i < page; ++i )
     {
-        region.x = -1;
-        region.y = -1;
-        region.width = 0;
-        region.height = 0;
-        return region;
+        self = self->next;
+    }
+    return self;
+}
+
+
+// ------------------------------------------------- texture_atlas_add_page ---
+texture_atlas_t *
+texture_atlas_add_page( texture_atlas_t * self )
+{
+    assert( self );
+
+    while( self->next )
+    {
+        self = self->next;
     }
+    self->next = self->channels > 1 ?
+        texture_atlas_new_channel_packed( self->width, self->height, self->packer ) :
+        texture_atlas_new_with_packer( self->width, self->height,
+                                       self->depth, self->packer );
+    self->next->max_width = self->max_width;
+    self->next->max_height = self->max_height;
+    return self->next;
+}
 
-    node = (ivec3 *) malloc( sizeof(ivec3) );
-    if( node == NULL)
+
+// ---------------------------------------------- texture_atlas_resize_page ---
+static void
+texture_atlas_resize_page( texture_atlas_t * self,
+                           const size_t width,
+                           const size_t height )
+{
+    // Space freed between the old and the new border
+    ivec4 right = {{self->width-1, 1, width - self->width, self->height-2}};
+    ivec4 bottom = {{1, self->height-1, width-2, height - self->height}};
+    unsigned char *data;
+    ivec4 *rect;
+    size_t i, j, leaves;
+    int x;
+
+    data = (unsigned char *) calloc( width*height*self->depth, sizeof(unsigned char) );
+    if( data == NULL )
     {
         fprintf( stderr,
                  "line %d: No more memory for allocating data\n", __LINE__ );
         exit( EXIT_FAILURE );
     }
-    node->x = region.x;
-    node->y = region.y + height;
-    node->z = width;
-    vector_insert( self->nodes, best_index, node );
-    free( node );
+    for( i = 0; i < self->height; ++i )
+    {
+        memcpy( data + i*width*self->depth,
+                self->data + i*self->width*self->depth,
+                self->width*self->depth );
+    }
+    free( self->data );
+    self->data = data;
 
-    for(i = best_index+1; i < self->nodes->size; ++i)
+    switch( self->packer )
     {
-        node = (ivec3 *) vector_get( self->nodes, i );
-        prev = (ivec3 *) vector_get( self->nodes, i-1 );
+    case PACKER_SKYLINE:
+        // Rebuild the segment tree over the wider skyline
+        self->nodes = (ivec3 *) realloc( self->nodes, width * sizeof(ivec3) );
+        for( leaves = 1; leaves < width; leaves *= 2 );
+        self->tree = (ivec4 *) realloc( self->tree, 2 * leaves * sizeof(ivec4) );
+        self->bounds = (ivec2 *) realloc( self->bounds, 2 * leaves * sizeof(ivec2) );
+        if( self->nodes == NULL || self->tree == NULL || self->bounds == NULL )
+        {
+            fprintf( stderr,
+                     "line %d: No more memory for allocating data\n", __LINE__ );
+            exit( EXIT_FAILURE );
+        }
+        memset( self->nodes + self->width, 0,
+                (width - self->width) * sizeof(ivec3) );
+        self->leaves = leaves;
+        texture_atlas_clear_tree( self );
+        for( x = 1, j = 0; x < (int)self->width - 1; x += self->nodes[x].z )
+        {
+            texture_atlas_set_node( self, x, self->nodes[x].y, self->nodes[x].z );
+            j = x;
+        }
+
+        // The new columns start empty, next to the last node
+        x = self->width - 1;
+        if( right.width == 0 )
+        {
+            break;
+        }
+        if( self->nodes[j].y == 1 )
+        {
+            texture_atlas_set_node( self, j, 1, self->nodes[j].z + right.width );
+        }
+        else
+        {
+            self->nodes[x].x = j;
+            texture_atlas_set_node( self, x, 1, right.width );
+        }
+        break;
 
-        if (node->x < (prev->x + prev->z) )
+    case PACKER_MAXRECTS:
+        // Free rectangles along the old border extend up to the new one
+        for( i = 0; i < self->free_rects->size; ++i )
         {
-            int shrink = prev->x + prev->z - node->x;
-            node->x += shrink;
-            node->z -= shrink;
-            if (node->z <= 0)
+            rect = (ivec4 *) vector_get( self->free_rects, i );
+            if( rect->x + rect->width == right.x )
             {
-                vector_erase( self->nodes, i );
-                --i;
+                rect->width += right.width;
             }
-            else
+            if( rect->y + rect->height == bottom.y )
             {
-                break;
+                rect->height += bottom.height;
             }
         }
-        else
+        right.height = height-2;
+        for( i = 0; i < self->free_rects->size; ++i )
         {
-            break;
+            rect = (ivec4 *) vector_get( self->free_rects, i );
+            if( texture_atlas_contains( rect, &right ) )
+            {
+                right.width = 0;
+            }
+            if( texture_atlas_contains( rect, &bottom ) )
+            {
+                bottom.height = 0;
+            }
         }
+        // fall through
+
+    case PACKER_GUILLOTINE:
+        if( right.width > 0 )
+        {
+            vector_push_back( self->free_rects, &right );
+        }
+        if( bottom.height > 0 )
+        {
+            vector_push_back( self->free_rects, &bottom );
+        }
+        break;
+
+    case PACKER_SHELF:
+        break;
     }
-    texture_atlas_merge( self );
-    self->used += width * height;
-    return region;
+
+    self->width = width;
+    self->height = height;
+
+    // The texture must be specified again at its new size
+    vector_clear( self->dirty );
+    texture_atlas_mark_dirty( self, 0, 0, width, height );
 }
 
 
-// ---------------------------------------------------- texture_atlas_clear ---
+// --------------------------------------------------- texture_atlas_resize ---
 void
-texture_atlas_clear( texture_atlas_t * self )
+texture_atlas_resize( texture_atlas_t * self,
+                      const size_t width,
+                      const size_t height )
 {
-    ivec3 node = {{1,1,1}};
+    size_t i;
 
     assert( self );
-    assert( self->data );
+    assert( width >= self->width && height >= self->height );
 
-    vector_clear( self->nodes );
-    self->used = 0;
-    // We want a one pixel border around the whole atlas to avoid any artefact when
-    // sampling texture
-    node.z = self->width-2;
-
-    vector_push_back( self->nodes, &node );
-    memset( self->data, 0, self->width*self->height*self->depth );
+    for( ; self; self = self->next )
+    {
+        if( width != self->width || height != self->height )
+        {
+            texture_atlas_resize_page( self, width, height );
+            for( i = 0; i < 3; ++i )
+            {
+                if( self->planes[i] )
+                {
+                    texture_atlas_resize_page( self->planes[i], width, height );
+                }
+            }
+        }
+        self->max_width = self->max_width > width ? self->max_width : width;
+        self->max_height = self->max_height > height ? self->max_height : height;
+    }
 }
@@ -72,6 +72,32 @@ namespace ftgl {
  * algorithm based on C++ sources provided by Jukka Jylänki at:
  * http://clb.demon.fi/files/RectangleBinPack/
  *
+ * Skyline nodes are indexed by the column they start at, under a segment tree
+ * holding the lowest and highest node of each span of columns, and the lowest
+ * a region wider than its nodes can rest. The search for the best position
+ * skips every span that cannot beat the best fit found so far, narrow wells
+ * included, and placing a region only updates the nodes it covers.
+ *
+ * Atlases created with texture_atlas_new_with_packer may use MaxRects (best
+ * short side fit, densest but slowest), guillotine (best area fit) or shelf
+ * (first fit, fastest but loosest) packing instead, from the same article.
+ *
+ * An atlas may be followed by further pages of the same size, depth and
+ * packer, each one a separate texture. Fonts allowed to use more than one
+ * page add them when a glyph does not fit in any existing page.
+ *
+ * An atlas may also start small and grow: texture_atlas_resize enlarges its
+ * pages in place, keeping the regions already allocated where they are, and
+ * fonts double the atlas size, up to max_width and max_height, before giving
+ * up on a glyph.
+ *
+ * A channel-packed atlas stores four independent planes of depth 1 in the
+ * red, green, blue and alpha channels of one RGBA texture, holding four times
+ * as many grayscale glyphs in the same texture memory. Each plane is an atlas
+ * of its own, given by texture_atlas_get_channel, in which regions are
+ * allocated, set and freed. Operations on the whole texture (upload, resize,
+ * clear, delete) apply to the four planes.
+ *
  *
  * Example Usage:
  * @code
@@ -96,15 +122,65 @@ namespace ftgl {
  */
 
 
+/**
+ * A list of possible algorithms to pack regions into an atlas.
+ */
+typedef enum texture_atlas_packer_t
+{
+    PACKER_SKYLINE,     /**< Skyline bottom-left, the default */
+    PACKER_MAXRECTS,    /**< MaxRects best short side fit, densest */
+    PACKER_GUILLOTINE,  /**< Guillotine best area fit */
+    PACKER_SHELF        /**< Shelf first fit, fastest */
+} texture_atlas_packer_t;
+
+
 /**
  * A texture atlas is used to pack several small regions into a single texture.
  */
 typedef struct texture_atlas_t
 {
     /**
-     * Allocated nodes
+     * Algorithm used to pack regions
+     */
+    texture_atlas_packer_t packer;
+
+    /**
+     * Skyline nodes (skyline packer), indexed by the column they start at: x
+     * is the start of the previous node, y the node height and z its width
+     * (zero when no node starts at that column)
      */
-    vector_t * nodes;
+    ivec3 * nodes;
+
+    /**
+     * Segment tree over the skyline columns used to search for the best fit:
+     * for each subtree, x is the lowest node height, y the highest node
+     * height, z the narrowest node width and w the leftmost node start
+     */
+    ivec4 * tree;
+
+    /**
+     * Second bound of the segment tree: for each subtree, x is the widest
+     * node and y the lowest a region wider than it may rest, on the higher
+     * of a node and the next one
+     */
+    ivec2 * bounds;
+
+    /**
+     * Number of leaves of the segment tree (a power of two)
+     */
+    size_t leaves;
+
+    /**
+     * Free rectangles: all the free space of MaxRects and guillotine packers,
+     * regions freed from the skyline and shelf packers
+     */
+    vector_t * free_rects;
+
+    /**
+     * Shelves (shelf packer): x is the shelf top, y its height and z the
+     * first free column
+     */
+    vector_t * shelves;
 
     /**
      *  Width (in pixels) of the underlying texture
@@ -121,6 +197,18 @@ typedef struct texture_atlas_t
      */
     size_t depth;
 
+    /**
+     * Width fonts may grow the atlas to when it is full (its initial width
+     * by default, so that it does not grow)
+     */
+    size_t max_width;
+
+    /**
+     * Height fonts may grow the atlas to when it is full (its initial height
+     * by default, so that it does not grow)
+     */
+    size_t max_height;
+
     /**
      * Allocated surface size
      */
@@ -131,11 +219,45 @@ typedef struct texture_atlas_t
      */
     unsigned int id;
 
+    /**
+     * Regions modified since the last texture_atlas_upload
+     */
+    vector_t * dirty;
+
+    /**
+     * Largest number of unmodified pixels uploaded to merge two modified
+     * regions into one (4096 by default)
+     */
+    size_t dirty_slack;
+
+    /**
+     * Number of planes packed in the channels of the texture: 1, or 4 for a
+     * channel-packed atlas, where the atlas itself is the red plane
+     */
+    size_t channels;
+
+    /**
+     * Green, blue and alpha planes of a channel-packed atlas (NULL otherwise)
+     */
+    struct texture_atlas_t * planes[3];
+
     /**
      * Atlas data
      */
     unsigned char * data;
 
+    /**
+     * Next page of the atlas (NULL if none)
+     */
+    struct texture_atlas_t * next;
+
+    /**
+     * Texture fonts placing glyphs in the atlas (texture_font_t *), kept by
+     * the fonts themselves so that growing the atlas for one of them rescales
+     * the texture coordinates of all. Fonts must be deleted before the atlas.
+     */
+    vector_t * fonts;
+
 } texture_atlas_t;
 
 
@@ -156,7 +278,39 @@ typedef struct texture_atlas_t
 
 
 /**
- *  Deletes a texture atlas.
+ * Creates a new empty texture atlas using a given packing algorithm.
+ *
+ * @param   width   width of the atlas
+ * @param   height  height of the atlas
+ * @param   depth   bit depth of the atlas
+ * @param   packer  algorithm used to pack regions
+ * @return          a new empty texture atlas.
+ *
+ */
+  texture_atlas_t *
+  texture_atlas_new_with_packer( const size_t width,
+                                 const size_t height,
+                                 const size_t depth,
+                                 const texture_atlas_packer_t packer );
+
+
+/**
+ * Creates a new empty channel-packed texture atlas of depth 1 planes.
+ *
+ * @param   width   width of the atlas
+ * @param   height  height of the atlas
+ * @param   packer  algorithm used to pack regions in each plane
+ * @return          a new empty texture atlas.
+ *
+ */
+  texture_atlas_t *
+  texture_atlas_new_channel_packed( const size_t width,
+                                    const size_t height,
+                                    const texture_atlas_packer_t packer );
+
+
+/**
+ *  Deletes a texture atlas and all its pages.
  *
  *  @param self a texture atlas structure
  *
@@ -202,7 +356,49 @@ typedef struct texture_atlas_t
                             const size_t stride );
 
 /**
- *  Remove all allocated regions from the atlas.
+ *  Record a region modified outside of texture_atlas_set_region, so that the
+ *  next texture_atlas_upload sends it. Pending regions are merged whenever
+ *  their bounding box carries no more than dirty_slack unmodified pixels.
+ *
+ *  @param self   a texture atlas structure
+ *  @param x      x coordinate the region
+ *  @param y      y coordinate the region
+ *  @param width  width of the region
+ *  @param height height of the region
+ */
+  void
+  texture_atlas_mark_dirty( texture_atlas_t * self,
+                            int x, int y, int width, int height );
+
+/**
+ *  Upload the regions modified since the last upload to the atlas texture,
+ *  creating the texture if the atlas id is 0. Each modified region is sent
+ *  with glTexSubImage2D, the whole atlas only after it was created, cleared
+ *  or resized. The texture is left bound to GL_TEXTURE_2D.
+ *
+ *  This is the only OpenGL call of the atlas and lives in texture-atlas-gl.c,
+ *  so that the packing itself stays usable without an OpenGL context.
+ *
+ *  @param self   a texture atlas structure
+ */
+  void
+  texture_atlas_upload( texture_atlas_t * self );
+
+
+/**
+ *  Give an allocated region back to the atlas so that later regions can
+ *  reuse it. Its pixels are cleared and it is merged with adjacent free
+ *  space whenever the union is a rectangle.
+ *
+ *  @param self   a texture atlas structure
+ *  @param region a region returned by texture_atlas_get_region
+ */
+  void
+  texture_atlas_free_region( texture_atlas_t * self,
+                             const ivec4 region );
+
+/**
+ *  Remove all allocated regions from the atlas and its pages.
  *
  *  @param self   a texture atlas structure
  */
@@ -210,6 +406,71 @@ typedef struct texture_atlas_t
   texture_atlas_clear( texture_atlas_t * self );
 
 
+/**
+ *  Enlarge the atlas and its pages, keeping allocated regions and their
+ *  pixels at the same place. Texture coordinates computed for the old size
+ *  must be scaled by the ratio of the old to the new size. Fonts growing the
+ *  atlas themselves rescale the glyphs of every font using it at once; after
+ *  a direct call, each font rescales its glyphs on its next lookup.
+ *
+ *  @param self   a texture atlas structure
+ *  @param width  new width, no smaller than the current one
+ *  @param height new height, no smaller than the current one
+ */
+  void
+  texture_atlas_resize( texture_atlas_t * self,
+                        const size_t width,
+                        const size_t height );
+
+
+/**
+ *  Exchange the pixels and allocated regions of two atlases (or pages) of the
+ *  same size, depth and packer. Texture ids and pages are left in place and
+ *  both atlases are uploaded whole on their next upload.
+ *
+ *  @param self   a texture atlas structure
+ *  @param other  another texture atlas structure
+ */
+  void
+  texture_atlas_swap( texture_atlas_t * self,
+                      texture_atlas_t * other );
+
+
+/**
+ *  Get a plane of a channel-packed atlas.
+ *
+ *  @param self    a texture atlas structure
+ *  @param channel texture channel of the plane, 0 being the atlas itself
+ *  @return        the requested plane or NULL if the atlas has no such channel
+ */
+  texture_atlas_t *
+  texture_atlas_get_channel( texture_atlas_t * self,
+                             const size_t channel );
+
+
+/**
+ *  Get a page of the atlas.
+ *
+ *  @param self   a texture atlas structure
+ *  @param page   index of the page, 0 being the atlas itself
+ *  @return       the requested page or NULL if the atlas has no such page
+ */
+  texture_atlas_t *
+  texture_atlas_get_page( texture_atlas_t * self,
+                          const size_t page );
+
+
+/**
+ *  Append a new empty page to the atlas, with the same size, depth and
+ *  packer as the atlas itself.
+ *
+ *  @param self   a texture atlas structure
+ *  @return       the new page
+ */
+  texture_atlas_t *
+  texture_atlas_add_page( texture_atlas_t * self );
+
+
 /** @} */
 
 #ifdef __cplusplus
@@ -34,6 +34,7 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_STROKER_H
+#include FT_OUTLINE_H
 // #include FT_ADVANCES_H
 #include FT_LCD_FILTER_H
 #include <stdint.h>
@@ -41,6 +42,14 @@
 #include <stdio.h>
 #include <assert.h>
 #include <math.h>
+#include <string.h>
+#ifdef FREETYPE_GL_USE_THREADS
+#  if defined(_WIN32) || defined(_WIN64)
+#    include <windows.h>
+#  else
+#    include <pthread.h>
+#  endif
+#endif
 #include "distance-field.h"
 #include "texture-font.h"
 #include "platform.h"
@@ -50,6 +59,42 @@
 #define HRESf 64.f
 #define DPI   72
 
+/* Rasterized glyph waiting for its place in the atlas */
+typedef struct texture_font_bitmap_t
+{
+    uint32_t codepoint;
+    size_t width;
+    size_t height;
+    int offset_x;
+    int offset_y;
+    float advance_x;
+    float advance_y;
+    unsigned char *buffer;
+} texture_font_bitmap_t;
+
+/* Share of a batch of glyphs rasterized by a thread with its own face,
+ * glyphs first, first + stride, ... of the batch */
+typedef struct texture_font_worker_t
+{
+    struct texture_font_t *font;
+    FT_Library library;
+    FT_Face face;
+    const uint32_t *codepoints;
+    texture_font_bitmap_t *bitmaps;
+    size_t count;
+    size_t first;
+    size_t stride;
+    distance_field_workspace_t *workspace;
+} texture_font_worker_t;
+
+/* Loaded codepoint chained to the previous one having the same glyph
+ * index, next is 1 + its position in the links vector or 0 */
+typedef struct texture_font_link_t
+{
+    uint32_t codepoint;
+    size_t next;
+} texture_font_link_t;
+
 #undef __FTERRORS_H__
 #define FT_ERRORDEF( e, v, s )  { e, s },
 #define FT_ERROR_START_LIST     {
@@ -60,10 +105,9 @@ const struct {
 } FT_Errors[] =
 #include FT_ERRORS_H
 
-// ------------------------------------------------- texture_font_load_face ---
+// ------------------------------------------------- texture_font_set_size ---
 static int
-texture_font_load_face(texture_font_t *self, float size,
-        FT_Library *library, FT_Face *face)
+texture_font_set_size( FT_Face face, float size )
 {
     FT_Error error;
     FT_Matrix matrix = {
@@ -72,11 +116,36 @@ texture_font_load_face(texture_font_t *self, float size,
         (int)((0.0)      * 0x10000L),
         (int)((1.0)      * 0x10000L)};
 
-    assert(library);
-    assert(size);
+    assert( face );
+    assert( size );
+
+    /* Set char size */
+    error = FT_Set_Char_Size( face, (int)(size * HRES), 0, DPI * HRES, DPI );
+
+    if( error )
+    {
+        fprintf( stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
+                 __LINE__, FT_Errors[error].code, FT_Errors[error].message );
+        return 0;
+    }
+
+    /* Set transform matrix */
+    FT_Set_Transform( face, &matrix, NULL );
+
+    return 1;
+}
+
+// ------------------------------------------------- texture_font_load_face ---
+static int
+texture_font_load_face( texture_font_t *self, float size,
+                        FT_Library *library, FT_Face *face )
+{
+    FT_Error error;
+
+    assert( size );
 
     /* Initialize library */
-    error = FT_Init_FreeType(library);
+    error = FT_Init_FreeType( library );
     if(error) {
         fprintf(stderr, "FT_Error (0x%02x) : %s\n",
                 FT_Errors[error].code, FT_Errors[error].message);
@@ -109,28 +178,37 @@ texture_font_load_face(texture_font_t *self, float size,
         goto cleanup_face;
     }
 
-    /* Set char size */
-    error = FT_Set_Char_Size(*face, (int)(size * HRES), 0, DPI * HRES, DPI);
-
-    if(error) {
-        fprintf(stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
-                __LINE__, FT_Errors[error].code, FT_Errors[error].message);
+    if( !texture_font_set_size( *face, size ) )
         goto cleanup_face;
-    }
-
-    /* Set transform matrix */
-    FT_Set_Transform(*face, &matrix, NULL);
 
     return 1;
 
 cleanup_face:
     FT_Done_Face( *face );
+    *face = NULL;
 cleanup_library:
     FT_Done_FreeType( *library );
+    *library = NULL;
 cleanup:
     return 0;
 }
 
+// ------------------------------------------------ texture_font_close_face ---
+static void
+texture_font_close_face( FT_Library *library, FT_Face *face )
+{
+    if( *face )
+    {
+        FT_Done_Face( *face );
+        *face = NULL;
+    }
+    if( *library )
+    {
+        FT_Done_FreeType( *library );
+        *library = NULL;
+    }
+}
+
 // ------------------------------------------------------ texture_glyph_new ---
 texture_glyph_t *
 texture_glyph_new(void)
@@ -155,7 +233,10 @@ texture_glyph_new(void)
     self->t0        = 0.0;
     self->s1        = 0.0;
     self->t1        = 0.0;
-    self->kerning   = vector_new( sizeof(kerning_t) );
+    self->kerning_index = NULL;
+    self->last_use  = 0;
+    self->page      = 0;
+    self->channel   = 0;
     return self;
 }
 
@@ -165,65 +246,275 @@ void
 texture_glyph_delete( texture_glyph_t *self )
 {
     assert( self );
-    vector_delete( self->kerning );
     free( self );
 }
 
+// ------------------------------------------------------ kerning_index_hash ---
+static size_t
+kerning_index_hash( uint32_t left, uint32_t right )
+{
+    uint32_t h = left * 0x9E3779B1u ^ right * 0x85EBCA77u;
+
+    h ^= h >> 15;
+    return h;
+}
+
+// ------------------------------------------------------- kerning_index_get ---
+static float
+kerning_index_get( const kerning_index_t * self,
+                   uint32_t left, uint32_t right )
+{
+    size_t i, mask;
+    const kerning_slot_t *slot;
+
+    if( (left | right) < 256 )
+    {
+        return self->latin1 ? self->latin1[left << 8 | right] : 0;
+    }
+    if( !self->capacity )
+    {
+        return 0;
+    }
+
+    mask = self->capacity - 1;
+    for( i = kerning_index_hash( left, right ) & mask; ; i = (i + 1) & mask )
+    {
+        slot = self->slots + i;
+        if( slot->left == left && slot->right == right )
+        {
+            return slot->kerning;
+        }
+        if( slot->left == (uint32_t)-1 )
+        {
+            return 0;
+        }
+    }
+}
+
+// ------------------------------------------------------ kerning_index_slot ---
+static kerning_slot_t *
+kerning_index_slot( kerning_slot_t * slots, size_t capacity,
+                    uint32_t left, uint32_t right )
+{
+    size_t i, mask = capacity - 1;
+
+    for( i = kerning_index_hash( left, right ) & mask; ; i = (i + 1) & mask )
+    {
+        if( (slots[i].left == left && slots[i].right == right)
+            || slots[i].left == (uint32_t)-1 )
+        {
+            return slots + i;
+        }
+    }
+}
+
+// ------------------------------------------------------- kerning_index_set ---
+static void
+kerning_index_set( kerning_index_t * self,
+                   uint32_t left, uint32_t right, float kerning )
+{
+    kerning_slot_t *slot, *slots;
+    size_t i, capacity;
+
+    if( (left | right) < 256 )
+    {
+        if( !self->latin1 )
+        {
+            self->latin1 = (float *) calloc( 256 * 256, sizeof(float) );
+            if( self->latin1 == NULL )
+            {
+                fprintf( stderr,
+                         "line %d: No more memory for allocating data\n", __LINE__ );
+                exit( EXIT_FAILURE );
+            }
+        }
+        if( self->latin1[left << 8 | right] == 0 )
+        {
+            self->count++;
+        }
+        self->latin1[left << 8 | right] = kerning;
+        return;
+    }
+
+    /* Keep the load factor at most 1/2 */
+    if( 2 * (self->hashed + 1) > self->capacity )
+    {
+        capacity = self->capacity ? 2 * self->capacity : 64;
+        slots = (kerning_slot_t *) malloc( capacity * sizeof(kerning_slot_t) );
+        if( slots == NULL )
+        {
+            fprintf( stderr,
+                     "line %d: No more memory for allocating data\n", __LINE__ );
+            exit( EXIT_FAILURE );
+        }
+        memset( slots, 0xFF, capacity * sizeof(kerning_slot_t) );
+        for( i = 0; i < self->capacity; ++i )
+        {
+            if( self->slots[i].left != (uint32_t)-1 )
+            {
+                *kerning_index_slot( slots, capacity, self->slots[i].left,
+                                     self->slots[i].right ) = self->slots[i];
+            }
+        }
+        free( self->slots );
+        self->slots = slots;
+        self->capacity = capacity;
+    }
+
+    slot = kerning_index_slot( self->slots, self->capacity, left, right );
+    if( slot->left == (uint32_t)-1 )
+    {
+        slot->left = left;
+        slot->right = right;
+        self->hashed++;
+        self->count++;
+    }
+    slot->kerning = kerning;
+}
+
+// ----------------------------------------------- texture_font_get_kerning ---
+float
+texture_font_get_kerning( const texture_font_t * self,
+                          uint32_t left,
+                          uint32_t right )
+{
+    assert( self );
+
+    return kerning_index_get( &self->kerning_index, left, right );
+}
+
 // ---------------------------------------------- texture_glyph_get_kerning ---
 float
 texture_glyph_get_kerning( const texture_glyph_t * self,
                            const char * codepoint )
 {
-    size_t i;
-    uint32_t ucodepoint = utf8_to_utf32( codepoint );
+    return texture_glyph_get_kerning_utf32( self, utf8_to_utf32( codepoint ) );
+}
 
+// ---------------------------------------- texture_glyph_get_kerning_utf32 ---
+float
+texture_glyph_get_kerning_utf32( const texture_glyph_t * self,
+                                 uint32_t codepoint )
+{
     assert( self );
-    for( i=0; i<vector_size(self->kerning); ++i )
+
+    if( !self->kerning_index )
     {
-        kerning_t * kerning = (kerning_t *) vector_get( self->kerning, i );
-        if( kerning->codepoint == ucodepoint )
-        {
-            return kerning->kerning;
-        }
+        return 0;
     }
-    return 0;
+    return kerning_index_get( self->kerning_index, codepoint, self->codepoint );
 }
 
 
 // ------------------------------------------ texture_font_generate_kerning ---
-void
+static void
 texture_font_generate_kerning( texture_font_t *self,
-                               FT_Library *library, FT_Face *face )
+                               texture_glyph_t *glyph )
 {
-    size_t i, j;
-    FT_UInt glyph_index, prev_index;
-    texture_glyph_t *glyph, *prev_glyph;
+    size_t i, j, first, count;
+    FT_UInt glyph_index, other_index;
+    texture_glyph_t *other;
     FT_Vector kerning;
 
     assert( self );
+    assert( glyph );
 
-    /* For each glyph couple combination, check if kerning is necessary */
-    /* Starts at index 1 since 0 is for the special backgroudn glyph */
-    for( i=1; i<self->glyphs->size; ++i )
+    glyph_index = FT_Get_Char_Index( self->face, glyph->codepoint );
+    if( self->kerning_table )
     {
-        glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
-        glyph_index = FT_Get_Char_Index( *face, glyph->codepoint );
-        vector_clear( glyph->kerning );
-
-        for( j=1; j<self->glyphs->size; ++j )
-        {
-            prev_glyph = *(texture_glyph_t **) vector_get( self->glyphs, j );
-            prev_index = FT_Get_Char_Index( *face, prev_glyph->codepoint );
-            FT_Get_Kerning( *face, prev_index, glyph_index, FT_KERNING_UNFITTED, &kerning );
-            // printf("%c(%d)-%c(%d): %ld\n",
-            //       prev_glyph->codepoint, prev_glyph->codepoint,
-            //       glyph_index, glyph_index, kerning.x);
-            if( kerning.x )
+        texture_font_link_t link = { glyph->codepoint, self->kerning_heads[glyph_index] };
+        texture_font_link_t *other_link;
+        const kerning_pair_t *pair;
+        FT_Fixed x_scale = self->face->size->metrics.x_scale;
+
+        /* Kerning is shared by the glyphs of a codepoint whatever their
+         * render mode, it is already known if the codepoint was loaded */
+        for( j = link.next; j; j = other_link->next )
+        {
+            other_link = (texture_font_link_t *) vector_get( self->kerning_links, j-1 );
+            if( other_link->codepoint == glyph->codepoint )
+            {
+                return;
+            }
+        }
+        vector_push_back( self->kerning_links, &link );
+        self->kerning_heads[glyph_index] = self->kerning_links->size;
+
+        /* other followed by glyph */
+        count = kerning_table_find_right( self->kerning_table, glyph_index, &first );
+        for( i = first; i < first + count; ++i )
+        {
+            pair = (const kerning_pair_t *)
+                vector_get( self->kerning_table->pairs_by_right, i );
+            kerning.x = FT_MulFix( pair->value, x_scale );
+            if( !kerning.x )
+                continue;
+            for( j = self->kerning_heads[pair->left]; j; j = other_link->next )
+            {
+                other_link = (texture_font_link_t *) vector_get( self->kerning_links, j-1 );
+                kerning_index_set( &self->kerning_index,
+                                   other_link->codepoint, glyph->codepoint,
+                                   kerning.x / (float)(HRESf*HRESf) );
+            }
+        }
+
+        /* glyph followed by other */
+        count = kerning_table_find_left( self->kerning_table, glyph_index, &first );
+        for( i = first; i < first + count; ++i )
+        {
+            pair = (const kerning_pair_t *)
+                vector_get( self->kerning_table->pairs, i );
+            kerning.x = FT_MulFix( pair->value, x_scale );
+            if( !kerning.x )
+                continue;
+            for( j = self->kerning_heads[pair->right]; j; j = other_link->next )
             {
-                kerning_t k = {prev_glyph->codepoint, kerning.x / (float)(HRESf*HRESf)};
-                vector_push_back( glyph->kerning, &k );
+                other_link = (texture_font_link_t *) vector_get( self->kerning_links, j-1 );
+                kerning_index_set( &self->kerning_index,
+                                   glyph->codepoint, other_link->codepoint,
+                                   kerning.x / (float)(HRESf*HRESf) );
             }
         }
+        return;
+    }
+
+    if( !FT_HAS_KERNING( self->face ) )
+    {
+        return;
+    }
+
+    /* Without readable tables every pair is probed. Only pairs involving
+     * the new glyph need to be computed, kerning between previously loaded
+     * glyphs is already known. */
+    for( i=0; i<self->glyphs->size; ++i )
+    {
+        other = *(texture_glyph_t **) vector_get( self->glyphs, i );
+
+        /* Skip the special background glyph */
+        if( other->codepoint == (uint32_t)-1 )
+        {
+            continue;
+        }
+
+        other_index = FT_Get_Char_Index( self->face, other->codepoint );
+
+        /* other followed by glyph */
+        FT_Get_Kerning( self->face, other_index, glyph_index, FT_KERNING_UNFITTED, &kerning );
+        if( kerning.x )
+        {
+            kerning_index_set( &self->kerning_index,
+                               other->codepoint, glyph->codepoint,
+                               kerning.x / (float)(HRESf*HRESf) );
+        }
+
+        /* glyph followed by other */
+        FT_Get_Kerning( self->face, glyph_index, other_index, FT_KERNING_UNFITTED, &kerning );
+        if( kerning.x )
+        {
+            kerning_index_set( &self->kerning_index,
+                               glyph->codepoint, other->codepoint,
+                               kerning.x / (float)(HRESf*HRESf) );
+        }
     }
 }
 
@@ -231,7 +522,6 @@ texture_font_generate_kerning( texture_font_t *self,
 static int
 texture_font_init(texture_font_t *self)
 {
-    FT_Library library;
     FT_Face face;
     FT_Size_Metrics metrics;
 
@@ -242,6 +532,15 @@ texture_font_init(texture_font_t *self)
             && self->memory.base && self->memory.size));
 
     self->glyphs = vector_new(sizeof(texture_glyph_t *));
+    self->glyph_index = NULL;
+    self->glyph_index_capacity = 0;
+    memset( self->latin1_glyphs, 0, sizeof(self->latin1_glyphs) );
+    self->latin1_rendermode = RENDER_NORMAL;
+    self->latin1_thickness = 0.0;
+    self->kerning_table = NULL;
+    self->kerning_heads = NULL;
+    self->kerning_links = NULL;
+    memset( &self->kerning_index, 0, sizeof(kerning_index_t) );
     self->height = 0;
     self->ascender = 0;
     self->descender = 0;
@@ -250,6 +549,17 @@ texture_font_init(texture_font_t *self)
     self->hinting = 1;
     self->kerning = 1;
     self->filtering = 1;
+    self->threads = 1;
+    self->max_pages = 1;
+    self->atlas_width = self->atlas->width;
+    self->atlas_height = self->atlas->height;
+    self->frame = 0;
+    self->evictable = NULL;
+    self->distance_field_method = DISTANCE_FIELD_EDTAA3;
+    self->distance_field_spread = 0;
+    self->workspace = NULL;
+    vector_push_back( self->atlas->fonts, &self );
+    memset( &self->stats, 0, sizeof(texture_font_stats_t) );
 
     // FT_LCD_FILTER_LIGHT   is (0x00, 0x55, 0x56, 0x55, 0x00)
     // FT_LCD_FILTER_DEFAULT is (0x10, 0x40, 0x70, 0x40, 0x10)
@@ -259,9 +569,27 @@ texture_font_init(texture_font_t *self)
     self->lcd_weights[3] = 0x40;
     self->lcd_weights[4] = 0x10;
 
-    if (!texture_font_load_face(self, self->size * 100.f, &library, &face))
+    /* The face is opened once and kept for subsequent glyph loads */
+    if (!texture_font_load_face(self, self->size, &self->library, &self->face))
         return -1;
 
+    face = self->face;
+
+    /* Kerning pairs are read once, only those involving loaded glyphs
+     * are then kept by the glyphs */
+    self->kerning_table = kerning_table_new( face );
+    if( self->kerning_table )
+    {
+        self->kerning_heads = (size_t *) calloc( face->num_glyphs, sizeof(size_t) );
+        self->kerning_links = vector_new( sizeof(texture_font_link_t) );
+        if( self->kerning_heads == NULL )
+        {
+            fprintf( stderr,
+                     "line %d: No more memory for allocating data\n", __LINE__ );
+            exit( EXIT_FAILURE );
+        }
+    }
+
     self->underline_position = face->underline_position / (float)(HRESf*HRESf) * self->size;
     self->underline_position = round( self->underline_position );
     if( self->underline_position > -2 )
@@ -276,13 +604,22 @@ texture_font_init(texture_font_t *self)
         self->underline_thickness = 1.0;
     }
 
+    /* Size metrics are rounded to integer pixels by FreeType, scale the
+     * design metrics ourselves to keep fractional values. */
     metrics = face->size->metrics;
-    self->ascender = (metrics.ascender >> 6) / 100.0;
-    self->descender = (metrics.descender >> 6) / 100.0;
-    self->height = (metrics.height >> 6) / 100.0;
+    if( FT_IS_SCALABLE( face ) )
+    {
+        self->ascender = FT_MulFix( face->ascender, metrics.y_scale ) / HRESf;
+        self->descender = FT_MulFix( face->descender, metrics.y_scale ) / HRESf;
+        self->height = FT_MulFix( face->height, metrics.y_scale ) / HRESf;
+    }
+    else
+    {
+        self->ascender = metrics.ascender / HRESf;
+        self->descender = metrics.descender / HRESf;
+        self->height = metrics.height / HRESf;
+    }
     self->linegap = self->height - self->ascender + self->descender;
-    FT_Done_Face( face );
-    FT_Done_FreeType( library );
 
     /* NULL is a special glyph */
     texture_font_get_glyph( self, NULL );
@@ -361,138 +698,409 @@ texture_font_delete( texture_font_t *self )
 
     assert( self );
 
+    texture_font_close_face( &self->library, &self->face );
+
     if(self->location == TEXTURE_FONT_FILE && self->filename)
         free( self->filename );
 
-    for( i=0; i<vector_size( self->glyphs ); ++i)
+    for( i = 0; i < vector_size( self->atlas->fonts ); ++i )
+    {
+        if( *(texture_font_t **) vector_get( self->atlas->fonts, i ) == self )
+        {
+            vector_erase( self->atlas->fonts, i );
+            break;
+        }
+    }
+
+    for( i=0; self->glyphs && i<vector_size( self->glyphs ); ++i)
     {
         glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
         texture_glyph_delete( glyph);
     }
 
-    vector_delete( self->glyphs );
+    if( self->glyphs )
+        vector_delete( self->glyphs );
+    if( self->evictable )
+        vector_delete( self->evictable );
+    if( self->workspace )
+        distance_field_workspace_delete( self->workspace );
+    free( self->glyph_index );
+    if( self->kerning_table )
+        kerning_table_delete( self->kerning_table );
+    free( self->kerning_heads );
+    if( self->kerning_links )
+        vector_delete( self->kerning_links );
+    free( self->kerning_index.latin1 );
+    free( self->kerning_index.slots );
     free( self );
 }
 
-texture_glyph_t *
-texture_font_find_glyph( texture_font_t * self,
-                         const char * codepoint )
+// ------------------------------------------------- texture_font_index_hash ---
+static size_t
+texture_font_index_hash( uint32_t codepoint,
+                         rendermode_t rendermode,
+                         float outline_thickness )
 {
-    size_t i;
+    uint32_t thickness;
+    uint32_t hash;
+
+    // The special glyph (-1) is shared by all modes and thicknesses
+    if( codepoint == (uint32_t)-1 )
+    {
+        return codepoint;
+    }
+
+    // Normalize -0.0 to 0.0 so that both hash to the same bucket
+    outline_thickness += 0.0f;
+    memcpy( &thickness, &outline_thickness, sizeof(uint32_t) );
+
+    hash  = codepoint * 2654435761u;
+    hash ^= (uint32_t)rendermode * 0x9E3779B9u;
+    hash ^= thickness + 0x7F4A7C15u + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+// ------------------------------------------------ texture_font_index_find ---
+static texture_glyph_t *
+texture_font_index_find( const texture_font_t * self,
+                         uint32_t codepoint )
+{
+    size_t mask, i;
     texture_glyph_t *glyph;
-    uint32_t ucodepoint = utf8_to_utf32( codepoint );
 
-    for( i = 0; i < self->glyphs->size; ++i )
+    if( !self->glyph_index )
+    {
+        return NULL;
+    }
+
+    mask = self->glyph_index_capacity - 1;
+    i = texture_font_index_hash( codepoint, self->rendermode,
+                                 self->outline_thickness ) & mask;
+
+    // Linear probing, the table is never full so an empty slot ends the search
+    while( (glyph = self->glyph_index[i]) )
     {
-        glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
         // If codepoint is -1, we don't care about outline type or thickness
-        if( (glyph->codepoint == ucodepoint) &&
-            ((ucodepoint == -1) ||
+        if( (glyph->codepoint == codepoint) &&
+            ((codepoint == (uint32_t)-1) ||
              ((glyph->rendermode == self->rendermode) &&
               (glyph->outline_thickness == self->outline_thickness)) ))
         {
             return glyph;
         }
+        i = (i + 1) & mask;
     }
 
     return NULL;
 }
 
-// ------------------------------------------------ texture_font_load_glyph ---
-int
-texture_font_load_glyph( texture_font_t * self,
-                         const char * codepoint )
+// ---------------------------------------------- texture_font_index_insert ---
+static void
+texture_font_index_insert( texture_glyph_t ** index,
+                           size_t capacity,
+                           texture_glyph_t * glyph )
 {
-    size_t i, x, y;
+    size_t mask = capacity - 1;
+    size_t i = texture_font_index_hash( glyph->codepoint, glyph->rendermode,
+                                        glyph->outline_thickness ) & mask;
 
-    FT_Library library;
-    FT_Error error;
-    FT_Face face;
-    FT_Glyph ft_glyph;
-    FT_GlyphSlot slot;
-    FT_Bitmap ft_bitmap;
+    while( index[i] )
+    {
+        i = (i + 1) & mask;
+    }
+    index[i] = glyph;
+}
 
-    FT_UInt glyph_index;
+// ----------------------------------------------- texture_font_index_build ---
+static void
+texture_font_index_build( texture_font_t * self,
+                          size_t capacity )
+{
+    size_t i;
     texture_glyph_t *glyph;
-    FT_Int32 flags = 0;
-    int ft_glyph_top = 0;
-    int ft_glyph_left = 0;
-
-    ivec4 region;
-    size_t missed = 0;
+    texture_glyph_t ** index = (texture_glyph_t **)
+        calloc( capacity, sizeof(texture_glyph_t *) );
 
-
-    if (!texture_font_load_face(self, self->size, &library, &face))
-        return 0;
-
-    /* Check if codepoint has been already loaded */
-    if (texture_font_find_glyph(self, codepoint)) {
-        FT_Done_Face(face);
-        FT_Done_FreeType(library);
-        return 1;
+    if( index == NULL )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
     }
-
-    /* codepoint NULL is special : it is used for line drawing (overline,
-     * underline, strikethrough) and background.
-     */
-    if( !codepoint )
+    for( i = 0; i < self->glyphs->size; ++i )
     {
-        ivec4 region = texture_atlas_get_region( self->atlas, 5, 5 );
-        texture_glyph_t * glyph = texture_glyph_new( );
-        static unsigned char data[4*4*3] = {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-                                            -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-                                            -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-                                            -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1};
-        if ( region.x < 0 )
-        {
-            fprintf( stderr, "Texture atlas is full (line %d)\n",  __LINE__ );
-            return NULL;
-        }
-        texture_atlas_set_region( self->atlas, region.x, region.y, 4, 4, data, 0 );
-        glyph->codepoint = -1;
-        glyph->s0 = (region.x+2)/(float)self->atlas->width;
-        glyph->t0 = (region.y+2)/(float)self->atlas->height;
-        glyph->s1 = (region.x+3)/(float)self->atlas->width;
-        glyph->t1 = (region.y+3)/(float)self->atlas->height;
-        vector_push_back( self->glyphs, &glyph );
-
-        FT_Done_Face(face);
-        FT_Done_FreeType(library);
-        return 1;
+        glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
+        texture_font_index_insert( index, capacity, glyph );
     }
+    free( self->glyph_index );
+    self->glyph_index = index;
+    self->glyph_index_capacity = capacity;
+}
 
-    flags = 0;
-    ft_glyph_top = 0;
-    ft_glyph_left = 0;
-    glyph_index = FT_Get_Char_Index( face, (FT_ULong)utf8_to_utf32( codepoint ) );
-    // WARNING: We use texture-atlas depth to guess if user wants
-    //          LCD subpixel rendering
+// ------------------------------------------------- texture_font_add_glyph ---
+static void
+texture_font_add_glyph( texture_font_t * self,
+                        texture_glyph_t * glyph )
+{
+    glyph->kerning_index = &self->kerning_index;
+    vector_push_back( self->glyphs, &glyph );
 
-    if( self->rendermode != RENDER_NORMAL && self->rendermode != RENDER_SIGNED_DISTANCE_FIELD )
+    // Keep load factor under 1/2, rehashing every glyph when growing
+    if( 2 * self->glyphs->size > self->glyph_index_capacity )
     {
-        flags |= FT_LOAD_NO_BITMAP;
+        texture_font_index_build( self, self->glyph_index_capacity ?
+                                        2 * self->glyph_index_capacity : 64 );
     }
     else
     {
-        flags |= FT_LOAD_RENDER;
+        texture_font_index_insert( self->glyph_index,
+                                   self->glyph_index_capacity, glyph );
     }
+}
 
-    if( !self->hinting )
+// ------------------------------------------------ texture_font_sync_atlas ---
+/* Rescales texture coordinates of all glyphs once the atlas has grown */
+static void
+texture_font_sync_atlas( texture_font_t * self )
+{
+    float sx, sy, width, height;
+    texture_glyph_t *glyph;
+    size_t i;
+
+    if( self->atlas_width == self->atlas->width &&
+        self->atlas_height == self->atlas->height )
+        return;
+
+    sx = (float) self->atlas_width;
+    sy = (float) self->atlas_height;
+    width = (float) self->atlas->width;
+    height = (float) self->atlas->height;
+    for( i = 0; i < self->glyphs->size; ++i )
     {
-        flags |= FT_LOAD_NO_HINTING | FT_LOAD_NO_AUTOHINT;
+        glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
+        glyph->s0 = floorf( glyph->s0 * sx + 0.5f ) / width;
+        glyph->t0 = floorf( glyph->t0 * sy + 0.5f ) / height;
+        glyph->s1 = floorf( glyph->s1 * sx + 0.5f ) / width;
+        glyph->t1 = floorf( glyph->t1 * sy + 0.5f ) / height;
     }
-    else
+    self->atlas_width = self->atlas->width;
+    self->atlas_height = self->atlas->height;
+}
+
+// ------------------------------------------- texture_font_find_glyph_utf32 ---
+texture_glyph_t *
+texture_font_find_glyph_utf32( texture_font_t * self,
+                               uint32_t codepoint )
+{
+    texture_glyph_t *glyph;
+
+    texture_font_sync_atlas( self );
+    if( codepoint >= 256 )
     {
-        flags |= FT_LOAD_FORCE_AUTOHINT;
+        return texture_font_index_find( self, codepoint );
     }
 
-    if( self->atlas->depth == 3 )
+    // The Latin-1 table holds glyphs of a single mode, start over when
+    // the mode changes
+    if( self->latin1_rendermode != self->rendermode
+        || self->latin1_thickness != self->outline_thickness )
     {
-        FT_Library_SetLcdFilter( library, FT_LCD_FILTER_LIGHT );
-        flags |= FT_LOAD_TARGET_LCD;
+        memset( self->latin1_glyphs, 0, sizeof(self->latin1_glyphs) );
+        self->latin1_rendermode = self->rendermode;
+        self->latin1_thickness = self->outline_thickness;
+    }
 
-        if( self->filtering )
-        {
+    glyph = self->latin1_glyphs[codepoint];
+    if( !glyph )
+    {
+        glyph = texture_font_index_find( self, codepoint );
+        self->latin1_glyphs[codepoint] = glyph;
+    }
+    return glyph;
+}
+
+// ------------------------------------------------ texture_font_find_glyph ---
+texture_glyph_t *
+texture_font_find_glyph( texture_font_t * self,
+                         const char * codepoint )
+{
+    const unsigned char *c = (const unsigned char *) codepoint;
+
+    texture_font_sync_atlas( self );
+    if( !c )
+    {
+        return texture_font_index_find( self, (uint32_t)-1 );
+    }
+
+    // ASCII and Latin-1 (0xC2 or 0xC3 lead byte) are decoded inline
+    if( c[0] < 0x80 )
+    {
+        return texture_font_find_glyph_utf32( self, c[0] );
+    }
+    if( (c[0] & 0xFE) == 0xC2 )
+    {
+        return texture_font_find_glyph_utf32( self,
+                                              ((c[0] & 0x1F) << 6) | (c[1] & 0x3F) );
+    }
+    return texture_font_index_find( self, utf8_to_utf32( codepoint ) );
+}
+
+// ------------------------------------------------- texture_font_workspace ---
+/* Distance field buffers of the calling thread, reused from glyph to glyph,
+ * or NULL when the font does not render distance fields. */
+static distance_field_workspace_t *
+texture_font_workspace( texture_font_t * self )
+{
+    if( self->rendermode != RENDER_SIGNED_DISTANCE_FIELD )
+        return NULL;
+    if( !self->workspace )
+        self->workspace = distance_field_workspace_new( 0 );
+    self->workspace->method = self->distance_field_method;
+    self->workspace->spread = self->distance_field_spread;
+    return self->workspace;
+}
+
+// ------------------------------------------------ texture_font_outline_t ---
+/* Segments of an outline being decomposed, in pixels of a field whose top
+ * left corner lies at (left,top) pixels from the glyph origin, y up */
+typedef struct texture_font_outline_t
+{
+    vector_t *segments;
+    distance_field_segment_t segment;
+    float left;
+    float top;
+} texture_font_outline_t;
+
+// ------------------------------------------------- texture_font_outline_to ---
+static int
+texture_font_outline_to( texture_font_outline_t *outline, int points,
+                         const FT_Vector *a, const FT_Vector *b,
+                         const FT_Vector *c )
+{
+    const FT_Vector *to[3] = { a, b, c };
+    distance_field_segment_t *segment = &outline->segment;
+    int i;
+
+    segment->points = points;
+    for( i = 1; i < points; ++i )
+    {
+        segment->x[i] = to[i-1]->x / HRESf - outline->left;
+        segment->y[i] = outline->top - to[i-1]->y / HRESf;
+    }
+    vector_push_back( outline->segments, segment );
+
+    // Next segment starts where this one ends
+    segment->x[0] = segment->x[points-1];
+    segment->y[0] = segment->y[points-1];
+    return 0;
+}
+
+static int
+texture_font_move_to( const FT_Vector *to, void *user )
+{
+    texture_font_outline_t *outline = (texture_font_outline_t *) user;
+
+    outline->segment.x[0] = to->x / HRESf - outline->left;
+    outline->segment.y[0] = outline->top - to->y / HRESf;
+    return 0;
+}
+
+static int
+texture_font_line_to( const FT_Vector *to, void *user )
+{
+    return texture_font_outline_to( user, 2, to, NULL, NULL );
+}
+
+static int
+texture_font_conic_to( const FT_Vector *control, const FT_Vector *to,
+                       void *user )
+{
+    return texture_font_outline_to( user, 3, control, to, NULL );
+}
+
+static int
+texture_font_cubic_to( const FT_Vector *control1, const FT_Vector *control2,
+                       const FT_Vector *to, void *user )
+{
+    return texture_font_outline_to( user, 4, control1, control2, to );
+}
+
+// ------------------------------------------ texture_font_decompose_outline ---
+void
+texture_font_decompose_outline( const FT_Outline * outline,
+                                float left, float top,
+                                vector_t * segments )
+{
+    FT_Outline_Funcs funcs = { texture_font_move_to, texture_font_line_to,
+                               texture_font_conic_to, texture_font_cubic_to,
+                               0, 0 };
+    texture_font_outline_t decomposed;
+
+    assert( outline );
+    assert( segments );
+
+    decomposed.segments = segments;
+    decomposed.left = left;
+    decomposed.top = top;
+    FT_Outline_Decompose( (FT_Outline *) outline, &funcs, &decomposed );
+}
+
+// ---------------------------------------------- texture_font_render_glyph ---
+static int
+texture_font_render_glyph( texture_font_t * self,
+                           FT_Library library,
+                           FT_Face face,
+                           uint32_t codepoint,
+                           distance_field_workspace_t * workspace,
+                           texture_font_bitmap_t * bitmap )
+{
+    size_t i;
+
+    FT_Error error;
+    FT_Glyph ft_glyph = NULL;
+    FT_GlyphSlot slot;
+    FT_Bitmap ft_bitmap;
+
+    FT_UInt glyph_index;
+    FT_Int32 flags = 0;
+    int ft_glyph_top = 0;
+    int ft_glyph_left = 0;
+    FT_BBox cbox;
+
+    // Distance fields computed from the outline need no bitmap
+    int outline = self->rendermode == RENDER_SIGNED_DISTANCE_FIELD
+               && self->distance_field_method == DISTANCE_FIELD_OUTLINE
+               && self->atlas->depth == 1;
+
+    glyph_index = FT_Get_Char_Index( face, (FT_ULong)codepoint );
+    // WARNING: We use texture-atlas depth to guess if user wants
+    //          LCD subpixel rendering
+
+    if( outline || (self->rendermode != RENDER_NORMAL && self->rendermode != RENDER_SIGNED_DISTANCE_FIELD) )
+    {
+        flags |= FT_LOAD_NO_BITMAP;
+    }
+    else
+    {
+        flags |= FT_LOAD_RENDER;
+    }
+
+    if( !self->hinting )
+    {
+        flags |= FT_LOAD_NO_HINTING | FT_LOAD_NO_AUTOHINT;
+    }
+    else
+    {
+        flags |= FT_LOAD_FORCE_AUTOHINT;
+    }
+
+    if( self->atlas->depth == 3 )
+    {
+        FT_Library_SetLcdFilter( library, FT_LCD_FILTER_LIGHT );
+        flags |= FT_LOAD_TARGET_LCD;
+
+        if( self->filtering )
+        {
             FT_Library_SetLcdFilterWeights( library, self->lcd_weights );
         }
     }
@@ -502,12 +1110,38 @@ texture_font_load_glyph( texture_font_t * self,
     {
         fprintf( stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
                  __LINE__, FT_Errors[error].code, FT_Errors[error].message );
-        FT_Done_Face( face );
-        FT_Done_FreeType( library );
         return 0;
     }
 
-    if( self->rendermode == RENDER_NORMAL || self->rendermode == RENDER_SIGNED_DISTANCE_FIELD )
+    // Fonts without outlines fall back to their bitmaps
+    if( outline && face->glyph->format != FT_GLYPH_FORMAT_OUTLINE )
+    {
+        outline = 0;
+        error = FT_Render_Glyph( face->glyph, FT_RENDER_MODE_NORMAL );
+        if( error )
+        {
+            fprintf( stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
+                     __LINE__, FT_Errors[error].code, FT_Errors[error].message );
+            return 0;
+        }
+    }
+
+    if( outline )
+    {
+        // Pixels the rasterizer would have covered
+        slot = face->glyph;
+        FT_Outline_Get_CBox( &slot->outline, &cbox );
+        cbox.xMin = cbox.xMin & ~(HRES - 1);
+        cbox.yMin = cbox.yMin & ~(HRES - 1);
+        cbox.xMax = (cbox.xMax + HRES - 1) & ~(HRES - 1);
+        cbox.yMax = (cbox.yMax + HRES - 1) & ~(HRES - 1);
+        ft_bitmap.width = (cbox.xMax - cbox.xMin) / HRES;
+        ft_bitmap.rows  = (cbox.yMax - cbox.yMin) / HRES;
+        ft_bitmap.buffer = NULL;
+        ft_glyph_top    = cbox.yMax / HRES;
+        ft_glyph_left   = cbox.xMin / HRES;
+    }
+    else if( self->rendermode == RENDER_NORMAL || self->rendermode == RENDER_SIGNED_DISTANCE_FIELD )
     {
         slot            = face->glyph;
         ft_bitmap       = slot->bitmap;
@@ -579,8 +1213,8 @@ cleanup_stroker:
 
         if( error )
         {
-            FT_Done_Face( face );
-            FT_Done_FreeType( library );
+            if( ft_glyph )
+                FT_Done_Glyph( ft_glyph );
             return 0;
         }
     }
@@ -596,6 +1230,14 @@ cleanup_stroker:
     {
         padding.top = 1;
         padding.left = 1;
+        if( self->distance_field_spread > 0 )
+        {
+            // Room for the field to fade out, the ink staying in place
+            padding.left = padding.top = padding.right = padding.bottom =
+                (int) ceilf( self->distance_field_spread );
+            ft_glyph_left -= padding.left;
+            ft_glyph_top += padding.top;
+        }
     }
 
     size_t src_w = ft_bitmap.width/self->atlas->depth;
@@ -604,82 +1246,774 @@ cleanup_stroker:
     size_t tgt_w = src_w + padding.left + padding.right;
     size_t tgt_h = src_h + padding.top + padding.bottom;
 
-    region = texture_atlas_get_region( self->atlas, tgt_w, tgt_h );
+    unsigned char *buffer = calloc( tgt_w * tgt_h, sizeof(unsigned char) );
 
-    if ( region.x < 0 )
+    for( i = 0; !outline && i < src_h; i++ )
     {
-        fprintf( stderr, "Texture atlas is full (line %d)\n",  __LINE__ );
+        memcpy( buffer + (i + padding.top) * tgt_w + padding.left, ft_bitmap.buffer + i * ft_bitmap.pitch, src_w );
+    }
+
+    if( self->rendermode != RENDER_NORMAL && self->rendermode != RENDER_SIGNED_DISTANCE_FIELD )
+        FT_Done_Glyph( ft_glyph );
+
+    if( outline )
+    {
+        vector_clear( workspace->segments );
+        texture_font_decompose_outline( &slot->outline,
+                                        (float) (cbox.xMin / HRES - padding.left),
+                                        (float) (cbox.yMax / HRES + padding.top),
+                                        workspace->segments );
+        make_distance_map_outline( workspace->segments->items,
+                                   vector_size( workspace->segments ),
+                                   slot->outline.flags & FT_OUTLINE_EVEN_ODD_FILL,
+                                   buffer, tgt_w, tgt_h, workspace );
+    }
+    else if( self->rendermode == RENDER_SIGNED_DISTANCE_FIELD )
+    {
+        make_distance_mapb_workspace( buffer, buffer, tgt_w, tgt_h, workspace );
+    }
+
+    bitmap->codepoint = codepoint;
+    bitmap->width     = tgt_w;
+    bitmap->height    = tgt_h;
+    bitmap->offset_x  = ft_glyph_left;
+    bitmap->offset_y  = ft_glyph_top;
+    bitmap->buffer    = buffer;
+
+    // Discard hinting to get advance
+    FT_Load_Glyph( face, glyph_index, FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
+    slot = face->glyph;
+    bitmap->advance_x = slot->advance.x / HRESf;
+    bitmap->advance_y = slot->advance.y / HRESf;
+
+    return 1;
+}
+
+// ---------------------------------------------- texture_font_glyph_region ---
+static ivec4
+texture_font_glyph_region( texture_font_t * self,
+                           const texture_glyph_t * glyph )
+{
+    ivec4 region;
+
+    region.x = (int)(glyph->s0 * self->atlas->width + 0.5f);
+    region.y = (int)(glyph->t0 * self->atlas->height + 0.5f);
+    region.width = (int) glyph->width;
+    region.height = (int) glyph->height;
+    return region;
+}
+
+// ----------------------------------------- texture_font_compare_last_use ---
+static int
+texture_font_compare_last_use( const void *a, const void *b )
+{
+    const texture_glyph_t *p = *(const texture_glyph_t **) a;
+    const texture_glyph_t *q = *(const texture_glyph_t **) b;
+
+    /* Most recently used first */
+    return p->last_use > q->last_use ? -1 : p->last_use < q->last_use;
+}
+
+// ------------------------------------------------ texture_font_grow_atlas ---
+/* Doubles the atlas size, up to its maximum size, returns 0 if it cannot.
+ * Glyphs of every font using the atlas are rescaled right away, so that
+ * glyphs already handed out stay valid. */
+static int
+texture_font_grow_atlas( texture_font_t * self )
+{
+    texture_atlas_t *atlas = self->atlas;
+    size_t i, width = 2 * atlas->width, height = 2 * atlas->height;
+
+    width = width < atlas->max_width ? width : atlas->max_width;
+    height = height < atlas->max_height ? height : atlas->max_height;
+    if( width <= atlas->width && height <= atlas->height )
         return 0;
+
+    texture_atlas_resize( atlas,
+                          width > atlas->width ? width : atlas->width,
+                          height > atlas->height ? height : atlas->height );
+    for( i = 0; i < vector_size( atlas->fonts ); ++i )
+    {
+        texture_font_sync_atlas( *(texture_font_t **) vector_get( atlas->fonts, i ) );
+    }
+    return 1;
+}
+
+// ----------------------------------------------- texture_font_find_region ---
+/* Allocates a region in the first atlas page and channel with room for it.
+ * On failure, page is the number of pages that were searched. */
+static ivec4
+texture_font_find_region( texture_font_t * self,
+                          size_t width,
+                          size_t height,
+                          size_t * page,
+                          size_t * channel )
+{
+    texture_atlas_t *atlas = self->atlas;
+    ivec4 region = {{-1,-1,0,0}};
+
+    for( *page = 0; atlas && *page < self->max_pages; atlas = atlas->next, ++*page )
+    {
+        for( *channel = 0; *channel < atlas->channels; ++*channel )
+        {
+            region = texture_atlas_get_region( texture_atlas_get_channel( atlas, *channel ),
+                                               width, height );
+            if( region.x >= 0 )
+                return region;
+        }
     }
+    return region;
+}
 
-    x = region.x;
-    y = region.y;
+// ------------------------------------------------ texture_font_get_region ---
+/* Allocates an atlas region, evicting glyphs unused in the current frame,
+ * least recently used first, while the atlas is full, then adding a page if
+ * the font may use one more. */
+static ivec4
+texture_font_get_region( texture_font_t * self,
+                         size_t width,
+                         size_t height,
+                         size_t * page,
+                         size_t * channel )
+{
+    ivec4 region;
+    texture_glyph_t *glyph;
+    size_t i, freed = 0, evicted = 0;
 
-    unsigned char *buffer = calloc( tgt_w * tgt_h, sizeof(unsigned char) );
+    texture_font_sync_atlas( self );
+    region = texture_font_find_region( self, width, height, page, channel );
+    while( region.x < 0 && texture_font_grow_atlas( self ) )
+        region = texture_font_find_region( self, width, height, page, channel );
 
-    for( i = 0; i < src_h; i++ )
+    if( region.x >= 0 )
+        return region;
+    if( !self->frame )
+        goto add_page;
+
+    /* Candidates are gathered once per frame */
+    if( !self->evictable )
     {
-        memcpy( buffer + (i + padding.top) * tgt_w + padding.left, ft_bitmap.buffer + i * ft_bitmap.pitch, src_w );
+        self->evictable = vector_new( sizeof(texture_glyph_t *) );
+        for( i = 0; i < self->glyphs->size; ++i )
+        {
+            glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
+            if( glyph->codepoint != (uint32_t)-1 && glyph->last_use < self->frame )
+                vector_push_back( self->evictable, &glyph );
+        }
+        qsort( self->evictable->items, self->evictable->size,
+               self->evictable->item_size, texture_font_compare_last_use );
     }
 
-    if( self->rendermode == RENDER_SIGNED_DISTANCE_FIELD )
+    while( region.x < 0 && self->evictable->size )
+    {
+        glyph = *(texture_glyph_t **) vector_back( self->evictable );
+        vector_pop_back( self->evictable );
+        if( glyph->last_use >= self->frame )
+            continue; /* Requested again during this frame */
+
+        texture_atlas_free_region( texture_atlas_get_channel(
+                                       texture_atlas_get_page( self->atlas, glyph->page ),
+                                       glyph->channel ),
+                                   texture_font_glyph_region( self, glyph ) );
+        glyph->last_use = (size_t)-1; /* Marks the glyph as evicted */
+        freed += glyph->width * glyph->height;
+        ++evicted;
+
+        /* Only look for room again once enough has been freed */
+        if( freed >= width * height || !self->evictable->size )
+            region = texture_font_find_region( self, width, height, page, channel );
+    }
+
+    if( evicted )
+    {
+        /* Drop evicted glyphs from the font and its indices */
+        for( i = 0, freed = 0; i < self->glyphs->size; ++i )
+        {
+            glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
+            if( glyph->last_use == (size_t)-1 )
+                texture_glyph_delete( glyph );
+            else
+                *(texture_glyph_t **) vector_get( self->glyphs, freed++ ) = glyph;
+        }
+        vector_resize( self->glyphs, freed );
+        texture_font_index_build( self, self->glyph_index_capacity );
+        memset( self->latin1_glyphs, 0, sizeof(self->latin1_glyphs) );
+        self->stats.evictions += evicted;
+    }
+
+add_page:
+    if( region.x < 0 && *page < self->max_pages )
+    {
+        region = texture_atlas_get_region( texture_atlas_add_page( self->atlas ),
+                                           width, height );
+        *channel = 0;
+    }
+    return region;
+}
+
+// ------------------------------------------------ texture_font_next_frame ---
+void
+texture_font_next_frame( texture_font_t * self )
+{
+    assert( self );
+
+    ++self->frame;
+    if( self->evictable )
+    {
+        vector_delete( self->evictable );
+        self->evictable = NULL;
+    }
+}
+
+/* A glyph moved by texture_font_compact, from region on page and channel to
+ * target on the page and channel of the same index in the shadow atlas */
+typedef struct texture_font_move_t
+{
+    texture_glyph_t * glyph;
+    ivec4 region, target;
+    size_t page, target_page;
+    size_t channel, target_channel;
+} texture_font_move_t;
+
+// ---------------------------------------------- texture_font_compare_move ---
+static int
+texture_font_compare_move( const void *a, const void *b )
+{
+    const texture_font_move_t *p = (const texture_font_move_t *) a;
+    const texture_font_move_t *q = (const texture_font_move_t *) b;
+
+    /* Tallest first, then widest first, then in atlas order */
+    if( p->region.height != q->region.height )
+        return p->region.height > q->region.height ? -1 : 1;
+    if( p->region.width != q->region.width )
+        return p->region.width > q->region.width ? -1 : 1;
+    if( p->page != q->page )
+        return p->page < q->page ? -1 : 1;
+    if( p->channel != q->channel )
+        return p->channel < q->channel ? -1 : 1;
+    if( p->region.y != q->region.y )
+        return p->region.y < q->region.y ? -1 : 1;
+    return p->region.x < q->region.x ? -1 : p->region.x > q->region.x;
+}
+
+// --------------------------------------------------- texture_font_compact ---
+size_t
+texture_font_compact( texture_atlas_t * atlas )
+{
+    texture_atlas_t *page, *shadow, *target;
+    texture_font_move_t *moves, *move;
+    texture_font_t **fonts;
+    texture_glyph_t *glyph;
+    size_t i, j, c, n = 0, pages = 0, used = 0, count;
+
+    assert( atlas );
+    fonts = (texture_font_t **) atlas->fonts->items;
+    count = atlas->fonts->size;
+    for( page = atlas; page; page = page->next )
     {
-        unsigned char *sdf = make_distance_mapb( buffer, tgt_w, tgt_h );
-        free( buffer );
-        buffer = sdf;
+        for( c = 0; c < page->channels; ++c )
+            used += texture_atlas_get_channel( page, c )->used;
+        ++pages;
     }
 
-    texture_atlas_set_region( self->atlas, x, y, tgt_w, tgt_h, buffer, tgt_w );
+    /* Where every live glyph lies now */
+    for( i = 0; i < count; ++i )
+    {
+        assert( fonts[i]->atlas == atlas );
+        texture_font_sync_atlas( fonts[i] );
+        n += fonts[i]->glyphs->size;
+    }
+    moves = (texture_font_move_t *) malloc( (n ? n : 1) * sizeof(texture_font_move_t) );
+    if( moves == NULL )
+    {
+        fprintf( stderr,
+                 "line %d: No more memory for allocating data\n", __LINE__ );
+        exit( EXIT_FAILURE );
+    }
+    for( i = 0, n = 0; i < count; ++i )
+    {
+        for( j = 0; j < fonts[i]->glyphs->size; ++j )
+        {
+            glyph = *(texture_glyph_t **) vector_get( fonts[i]->glyphs, j );
+            if( glyph->codepoint != (uint32_t)-1 &&
+                (!glyph->width || !glyph->height) )
+                continue; /* Empty glyphs hold no atlas region */
+            move = moves + n++;
+            move->glyph = glyph;
+            move->page = glyph->page;
+            move->channel = glyph->channel;
+            move->region = texture_font_glyph_region( fonts[i], glyph );
+            if( glyph->codepoint == (uint32_t)-1 )
+            {
+                /* The special glyph samples the middle of a 5x5 region */
+                move->region.x -= 2;
+                move->region.y -= 2;
+                move->region.width = 5;
+                move->region.height = 5;
+            }
+        }
+    }
 
-    free( buffer );
+    /* Repack them, largest first, into a shadow atlas with no more pages */
+    qsort( moves, n, sizeof(texture_font_move_t), texture_font_compare_move );
+    shadow = atlas->channels > 1 ?
+        texture_atlas_new_channel_packed( atlas->width, atlas->height, atlas->packer ) :
+        texture_atlas_new_with_packer( atlas->width, atlas->height,
+                                       atlas->depth, atlas->packer );
+    for( i = 0; i < n; ++i )
+    {
+        move = moves + i;
+        move->target_page = 0;
+        move->target_channel = 0;
+        for( target = shadow; ; )
+        {
+            if( !target )
+            {
+                if( move->target_page == pages )
+                {
+                    /* The new layout is no tighter, keep the current one */
+                    texture_atlas_delete( shadow );
+                    free( moves );
+                    return 0;
+                }
+                target = texture_atlas_add_page( shadow );
+            }
+            move->target = texture_atlas_get_region(
+                texture_atlas_get_channel( target, move->target_channel ),
+                move->region.width, move->region.height );
+            if( move->target.x >= 0 )
+                break;
+            if( ++move->target_channel == target->channels )
+            {
+                move->target_channel = 0;
+                target = target->next;
+                ++move->target_page;
+            }
+        }
+        target = texture_atlas_get_channel( target, move->target_channel );
+        page = texture_atlas_get_channel( texture_atlas_get_page( atlas, move->page ),
+                                          move->channel );
+        texture_atlas_set_region( target, move->target.x, move->target.y,
+                                  move->region.width, move->region.height,
+                                  page->data + (move->region.y*page->width
+                                                + move->region.x) * page->depth,
+                                  page->width * page->depth );
+    }
+
+    /* Swap the layouts and move every glyph along */
+    for( page = atlas, target = shadow; page; page = page->next )
+    {
+        if( !target )
+        {
+            texture_atlas_clear( page );
+            break;
+        }
+        for( c = 0; c < page->channels; ++c )
+        {
+            texture_atlas_swap( texture_atlas_get_channel( page, c ),
+                                texture_atlas_get_channel( target, c ) );
+            used -= texture_atlas_get_channel( page, c )->used;
+        }
+        target = target->next;
+    }
+    for( i = 0; i < n; ++i )
+    {
+        move = moves + i;
+        glyph = move->glyph;
+        if( glyph->codepoint == (uint32_t)-1 )
+        {
+            glyph->s0 = (move->target.x+2)/(float)atlas->width;
+            glyph->t0 = (move->target.y+2)/(float)atlas->height;
+            glyph->s1 = (move->target.x+3)/(float)atlas->width;
+            glyph->t1 = (move->target.y+3)/(float)atlas->height;
+        }
+        else
+        {
+            glyph->s0 = move->target.x/(float)atlas->width;
+            glyph->t0 = move->target.y/(float)atlas->height;
+            glyph->s1 = (move->target.x + glyph->width)/(float)atlas->width;
+            glyph->t1 = (move->target.y + glyph->height)/(float)atlas->height;
+        }
+        glyph->page = move->target_page;
+        glyph->channel = move->target_channel;
+    }
+
+    texture_atlas_delete( shadow );
+    free( moves );
+    return used;
+}
+
+// ----------------------------------------------- texture_font_place_glyph ---
+static texture_glyph_t *
+texture_font_place_glyph( texture_font_t * self,
+                          const texture_font_bitmap_t * bitmap )
+{
+    size_t x, y, page, channel;
+    texture_glyph_t *glyph;
+    ivec4 region;
+
+    region = texture_font_get_region( self, bitmap->width, bitmap->height,
+                                      &page, &channel );
+
+    if ( region.x < 0 )
+    {
+        fprintf( stderr, "Texture atlas is full (line %d)\n",  __LINE__ );
+        return NULL;
+    }
+
+    x = region.x;
+    y = region.y;
+
+    texture_atlas_set_region( texture_atlas_get_channel(
+                                  texture_atlas_get_page( self->atlas, page ), channel ),
+                              x, y, bitmap->width, bitmap->height,
+                              bitmap->buffer, bitmap->width );
 
     glyph = texture_glyph_new( );
-    glyph->codepoint = utf8_to_utf32( codepoint );
-    glyph->width    = tgt_w;
-    glyph->height   = tgt_h;
+    glyph->codepoint = bitmap->codepoint;
+    glyph->width    = bitmap->width;
+    glyph->height   = bitmap->height;
     glyph->rendermode = self->rendermode;
     glyph->outline_thickness = self->outline_thickness;
-    glyph->offset_x = ft_glyph_left;
-    glyph->offset_y = ft_glyph_top;
+    glyph->offset_x = bitmap->offset_x;
+    glyph->offset_y = bitmap->offset_y;
     glyph->s0       = x/(float)self->atlas->width;
     glyph->t0       = y/(float)self->atlas->height;
     glyph->s1       = (x + glyph->width)/(float)self->atlas->width;
     glyph->t1       = (y + glyph->height)/(float)self->atlas->height;
+    glyph->advance_x = bitmap->advance_x;
+    glyph->advance_y = bitmap->advance_y;
+    glyph->last_use = self->frame;
+    glyph->page     = page;
+    glyph->channel  = channel;
 
-    // Discard hinting to get advance
-    FT_Load_Glyph( face, glyph_index, FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
-    slot = face->glyph;
-    glyph->advance_x = slot->advance.x / HRESf;
-    glyph->advance_y = slot->advance.y / HRESf;
+    texture_font_add_glyph( self, glyph );
 
-    vector_push_back( self->glyphs, &glyph );
+    return glyph;
+}
 
-    if( self->rendermode != RENDER_NORMAL && self->rendermode != RENDER_SIGNED_DISTANCE_FIELD )
-        FT_Done_Glyph( ft_glyph );
+// ------------------------------------------------ texture_font_load_glyph ---
+int
+texture_font_load_glyph( texture_font_t * self,
+                         const char * codepoint )
+{
+    return texture_font_load_glyph_utf32( self, utf8_to_utf32( codepoint ) );
+}
+
+// ------------------------------------------ texture_font_load_glyph_utf32 ---
+int
+texture_font_load_glyph_utf32( texture_font_t * self,
+                               uint32_t codepoint )
+{
+    texture_font_bitmap_t bitmap;
+    texture_glyph_t *glyph;
+
+    /* Check if codepoint has been already loaded */
+    if (texture_font_find_glyph_utf32(self, codepoint))
+        return 1;
+
+    /* codepoint -1 is special : it is used for line drawing (overline,
+     * underline, strikethrough) and background.
+     */
+    if( codepoint == (uint32_t)-1 )
+    {
+        size_t page, channel;
+        ivec4 region = texture_font_get_region( self, 5, 5, &page, &channel );
+        texture_glyph_t * glyph = texture_glyph_new( );
+        static unsigned char data[4*4*3] = {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                                            -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                                            -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                                            -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1};
+        if ( region.x < 0 )
+        {
+            fprintf( stderr, "Texture atlas is full (line %d)\n",  __LINE__ );
+            texture_glyph_delete( glyph );
+            return 0;
+        }
+        texture_atlas_set_region( texture_atlas_get_channel(
+                                      texture_atlas_get_page( self->atlas, page ), channel ),
+                                  region.x, region.y, 4, 4, data, 0 );
+        glyph->codepoint = -1;
+        glyph->page = page;
+        glyph->channel = channel;
+        glyph->s0 = (region.x+2)/(float)self->atlas->width;
+        glyph->t0 = (region.y+2)/(float)self->atlas->height;
+        glyph->s1 = (region.x+3)/(float)self->atlas->width;
+        glyph->t1 = (region.y+3)/(float)self->atlas->height;
+        texture_font_add_glyph( self, glyph );
 
-    texture_font_generate_kerning( self, &library, &face );
+        return 1;
+    }
+
+    if( !texture_font_render_glyph( self, self->library, self->face,
+                                    codepoint, texture_font_workspace( self ),
+                                    &bitmap ) )
+        return 0;
+
+    glyph = texture_font_place_glyph( self, &bitmap );
+    free( bitmap.buffer );
+    if( !glyph )
+        return 0;
 
-    FT_Done_Face( face );
-    FT_Done_FreeType( library );
+    texture_font_generate_kerning( self, glyph );
 
     return 1;
 }
 
+// ----------------------------------------------- texture_font_worker_run ---
+static void
+texture_font_worker_run( texture_font_worker_t * worker )
+{
+    size_t i;
+
+    for( i = worker->first; i < worker->count; i += worker->stride )
+    {
+        if( !texture_font_render_glyph( worker->font,
+                                        worker->library, worker->face,
+                                        worker->codepoints[i],
+                                        worker->workspace,
+                                        worker->bitmaps + i ) )
+        {
+            worker->bitmaps[i].buffer = NULL;
+        }
+    }
+}
+
+#ifdef FREETYPE_GL_USE_THREADS
+// ---------------------------------------------- texture_font_worker_main ---
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI
+texture_font_worker_main( LPVOID data )
+#else
+static void *
+texture_font_worker_main( void * data )
+#endif
+{
+    texture_font_worker_run( (texture_font_worker_t *) data );
+    return 0;
+}
+#endif
+
+// ----------------------------------------------- texture_font_rasterize ---
+/* Renders count glyphs into bitmaps, the buffer of a bitmap is NULL when
+ * its glyph could not be rendered. */
+static void
+texture_font_rasterize( texture_font_t * self,
+                        const uint32_t * codepoints,
+                        size_t count,
+                        texture_font_bitmap_t * bitmaps )
+{
+    texture_font_worker_t worker = { self, self->library, self->face,
+                                     codepoints, bitmaps, count, 0, 1,
+                                     texture_font_workspace( self ) };
+#ifdef FREETYPE_GL_USE_THREADS
+    size_t i, threads = self->threads < count ? self->threads : count;
+    texture_font_worker_t *workers;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE *handles;
+#else
+    pthread_t *handles;
+    int *started;
+#endif
+
+    if( threads > 1 )
+    {
+        workers = (texture_font_worker_t *)
+            calloc( threads, sizeof(texture_font_worker_t) );
+#if defined(_WIN32) || defined(_WIN64)
+        handles = (HANDLE *) calloc( threads, sizeof(HANDLE) );
+#else
+        handles = (pthread_t *) calloc( threads, sizeof(pthread_t) );
+        started = (int *) calloc( threads, sizeof(int) );
+        if( started == NULL )
+        {
+            fprintf( stderr,
+                     "line %d: No more memory for allocating data\n", __LINE__ );
+            exit( EXIT_FAILURE );
+        }
+#endif
+        if( workers == NULL || handles == NULL )
+        {
+            fprintf( stderr,
+                     "line %d: No more memory for allocating data\n", __LINE__ );
+            exit( EXIT_FAILURE );
+        }
+
+        /* Glyphs are dealt in turn to the workers. The calling thread is
+         * the first worker and uses the font face, the other ones open a
+         * face of their own since faces cannot be shared between threads. */
+        for( i = 0; i < threads; ++i )
+        {
+            workers[i] = worker;
+            workers[i].first = i;
+            workers[i].stride = threads;
+            if( i && !texture_font_load_face( self, self->size,
+                                              &workers[i].library,
+                                              &workers[i].face ) )
+            {
+                workers[i].library = self->library;
+                workers[i].face = self->face;
+                continue;
+            }
+            if( i && worker.workspace )
+            {
+                workers[i].workspace = distance_field_workspace_new( 0 );
+                workers[i].workspace->method = self->distance_field_method;
+                workers[i].workspace->spread = self->distance_field_spread;
+            }
+#if defined(_WIN32) || defined(_WIN64)
+            if( i )
+                handles[i] = CreateThread( NULL, 0, texture_font_worker_main,
+                                           workers + i, 0, NULL );
+#else
+            if( i )
+                started[i] = !pthread_create( handles + i, NULL,
+                                              texture_font_worker_main,
+                                              workers + i );
+#endif
+        }
+
+        texture_font_worker_run( workers );
+        for( i = 1; i < threads; ++i )
+        {
+            if( workers[i].face == self->face )
+            {
+                /* No face could be opened for this worker */
+                texture_font_worker_run( workers + i );
+                continue;
+            }
+#if defined(_WIN32) || defined(_WIN64)
+            if( handles[i] )
+            {
+                WaitForSingleObject( handles[i], INFINITE );
+                CloseHandle( handles[i] );
+            }
+            else
+#else
+            if( started[i] )
+                pthread_join( handles[i], NULL );
+            else
+#endif
+            {
+                /* The thread could not be started */
+                texture_font_worker_run( workers + i );
+            }
+            texture_font_close_face( &workers[i].library, &workers[i].face );
+            if( workers[i].workspace )
+                distance_field_workspace_delete( workers[i].workspace );
+        }
+
+#if !defined(_WIN32) && !defined(_WIN64)
+        free( started );
+#endif
+        free( handles );
+        free( workers );
+        return;
+    }
+#endif
+
+    texture_font_worker_run( &worker );
+}
+
+// ------------------------------------------ texture_font_compare_codepoint ---
+static int
+texture_font_compare_codepoint( const void *a, const void *b )
+{
+    uint32_t p = *(const uint32_t *) a;
+    uint32_t q = *(const uint32_t *) b;
+
+    return p < q ? -1 : p > q;
+}
+
+// -------------------------------------------- texture_font_compare_bitmap ---
+static int
+texture_font_compare_bitmap( const void *a, const void *b )
+{
+    const texture_font_bitmap_t *p = (const texture_font_bitmap_t *) a;
+    const texture_font_bitmap_t *q = (const texture_font_bitmap_t *) b;
+
+    /* Tallest first, then widest first */
+    if( p->height != q->height )
+        return p->height > q->height ? -1 : 1;
+    if( p->width != q->width )
+        return p->width > q->width ? -1 : 1;
+    return texture_font_compare_codepoint( &p->codepoint, &q->codepoint );
+}
+
 // ----------------------------------------------- texture_font_load_glyphs ---
 size_t
 texture_font_load_glyphs( texture_font_t * self,
                           const char * codepoints )
 {
-    size_t i;
+    size_t i, count, rendered, missed = 0;
+    vector_t *pending, *bitmaps, *glyphs;
+    texture_font_bitmap_t bitmap;
+    texture_glyph_t *glyph;
+    uint32_t codepoint;
 
-    /* Load each glyph */
-    for( i = 0; i < utf8_strlen(codepoints); i += utf8_surrogate_len(codepoints + i) ) {
-        if( !texture_font_load_glyph( self, codepoints + i ) )
-            return utf8_strlen( codepoints + i );
+    assert( self );
+    assert( codepoints );
 
+    /* Glyphs not loaded yet, without duplicates */
+    pending = vector_new( sizeof(uint32_t) );
+    for( i = 0; codepoints[i]; i += utf8_surrogate_len( codepoints + i ) )
+    {
+        codepoint = utf8_to_utf32( codepoints + i );
+        if( !texture_font_index_find( self, codepoint ) )
+            vector_push_back( pending, &codepoint );
     }
+    qsort( pending->items, pending->size, pending->item_size,
+           texture_font_compare_codepoint );
 
-    return 0;
+    /* Rasterize every glyph first ... */
+    for( i = 0, count = 0; i < pending->size; ++i )
+    {
+        codepoint = *(uint32_t *) vector_get( pending, i );
+        if( !count || codepoint != *(uint32_t *) vector_get( pending, count-1 ) )
+            *(uint32_t *) vector_get( pending, count++ ) = codepoint;
+    }
+    bitmaps = vector_new( sizeof(texture_font_bitmap_t) );
+    vector_resize( bitmaps, count );
+    texture_font_rasterize( self, (const uint32_t *) pending->items, count,
+                            (texture_font_bitmap_t *) bitmaps->items );
+    vector_delete( pending );
+    for( i = 0, rendered = 0; i < count; ++i )
+    {
+        bitmap = *(texture_font_bitmap_t *) vector_get( bitmaps, i );
+        if( bitmap.buffer )
+            *(texture_font_bitmap_t *) vector_get( bitmaps, rendered++ ) = bitmap;
+        else
+            ++missed;
+    }
+    vector_resize( bitmaps, rendered );
+
+    /* ... then pack them largest first, which wastes less atlas space
+     * than packing them in string order ... */
+    qsort( bitmaps->items, bitmaps->size, bitmaps->item_size,
+           texture_font_compare_bitmap );
+    glyphs = vector_new( sizeof(texture_glyph_t *) );
+    vector_reserve( glyphs, bitmaps->size );
+    for( i = 0; i < bitmaps->size; ++i )
+    {
+        texture_font_bitmap_t *b = (texture_font_bitmap_t *) vector_get( bitmaps, i );
+        glyph = texture_font_place_glyph( self, b );
+        if( glyph )
+            vector_push_back( glyphs, &glyph );
+        else
+            ++missed;
+        free( b->buffer );
+    }
+    vector_delete( bitmaps );
+
+    /* ... and compute the kerning of the new glyphs once they are all in */
+    for( i = 0; i < glyphs->size; ++i )
+    {
+        texture_font_generate_kerning( self,
+                                       *(texture_glyph_t **) vector_get( glyphs, i ) );
+    }
+    vector_delete( glyphs );
+
+    return missed;
 }
 
 
@@ -696,11 +2030,68 @@ texture_font_get_glyph( texture_font_t * self,
 
     /* Check if codepoint has been already loaded */
     if( (glyph = texture_font_find_glyph( self, codepoint )) )
+    {
+        glyph->last_use = self->frame;
+        ++self->stats.hits;
+        return glyph;
+    }
+
+    /* Glyph has not been already loaded */
+    return texture_font_get_glyph_utf32( self, utf8_to_utf32( codepoint ) );
+}
+
+// ------------------------------------------- texture_font_get_glyph_utf32 ---
+texture_glyph_t *
+texture_font_get_glyph_utf32( texture_font_t * self,
+                              uint32_t codepoint )
+{
+    texture_glyph_t *glyph;
+
+    assert( self );
+    assert( self->atlas );
+
+    /* Check if codepoint has been already loaded */
+    if( (glyph = texture_font_find_glyph_utf32( self, codepoint )) )
+    {
+        glyph->last_use = self->frame;
+        ++self->stats.hits;
         return glyph;
+    }
 
     /* Glyph has not been already loaded */
-    if( texture_font_load_glyph( self, codepoint ) )
-        return texture_font_find_glyph( self, codepoint );
+    ++self->stats.misses;
+    if( texture_font_load_glyph_utf32( self, codepoint ) )
+        return texture_font_find_glyph_utf32( self, codepoint );
 
     return NULL;
 }
+
+// --------------------------------------------- texture_font_get_charcodes ---
+size_t
+texture_font_get_charcodes( texture_font_t * self,
+                            uint32_t * codepoints,
+                            size_t max )
+{
+    size_t count = 0;
+    FT_ULong charcode;
+    FT_UInt index;
+
+    assert( self );
+    assert( self->face );
+
+    charcode = FT_Get_First_Char( self->face, &index );
+    while( index && count < max )
+    {
+        if( charcode >= 0x20 && (charcode < 0x7F || charcode >= 0xA0) )
+        {
+            if( codepoints )
+            {
+                codepoints[count] = charcode;
+            }
+            ++count;
+        }
+        charcode = FT_Get_Next_Char( self->face, charcode, &index );
+    }
+
+    return count;
+}
@@ -37,12 +37,17 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #include "vector.h"
 #include "texture-atlas.h"
+#include "kerning-table.h"
+#include "distance-field.h"
 
 #ifdef __cplusplus
 namespace ftgl {
@@ -105,6 +110,69 @@ typedef struct kerning_t
 } kerning_t;
 
 
+/**
+ * A kerning value between two Unicode codepoints, slot of the kerning
+ * index hash table.
+ */
+typedef struct kerning_slot_t
+{
+    /**
+     * Left Unicode codepoint, -1 for a free slot.
+     */
+    uint32_t left;
+
+    /**
+     * Right Unicode codepoint.
+     */
+    uint32_t right;
+
+    /**
+     * Kerning value (in fractional pixels).
+     */
+    float kerning;
+
+} kerning_slot_t;
+
+
+/**
+ * Kerning values between the codepoints loaded in a font.
+ *
+ * Pairs of Latin-1 codepoints are stored in a dense table, the other
+ * ones in an open addressing hash table keyed on the (left, right)
+ * codepoints.
+ */
+typedef struct kerning_index_t
+{
+    /**
+     * Kerning of left and right codepoints below 256, at left * 256 + right.
+     * NULL until such a pair is known.
+     */
+    float * latin1;
+
+    /**
+     * Hash table holding the other pairs. Its capacity is always a power
+     * of two.
+     */
+    kerning_slot_t * slots;
+
+    /**
+     * Number of slots in the hash table.
+     */
+    size_t capacity;
+
+    /**
+     * Number of pairs held by the hash table.
+     */
+    size_t hashed;
+
+    /**
+     * Number of pairs in the index.
+     */
+    size_t count;
+
+} kerning_index_t;
+
+
 
 
 /*
@@ -208,9 +276,9 @@ typedef struct texture_glyph_t
     float t1;
 
     /**
-     * A vector of kerning pairs relative to this glyph.
+     * Kerning index of the font this glyph belongs to, NULL if none.
      */
-    vector_t * kerning;
+    const kerning_index_t * kerning_index;
 
     /**
      * Mode this glyph was rendered
@@ -222,9 +290,49 @@ typedef struct texture_glyph_t
      */
     float outline_thickness;
 
+    /**
+     * Frame of the font this glyph was last requested in
+     */
+    size_t last_use;
+
+    /**
+     * Atlas page holding the glyph, 0 being the font atlas itself
+     */
+    size_t page;
+
+    /**
+     * Texture channel holding the glyph in a channel-packed atlas, 0 (red)
+     * otherwise
+     */
+    size_t channel;
+
 } texture_glyph_t;
 
 
+/**
+ * Glyph cache statistics of a texture font. The hit rate is hits divided by
+ * hits plus misses.
+ */
+typedef struct texture_font_stats_t
+{
+    /**
+     * Glyph requests served by an already loaded glyph
+     */
+    size_t hits;
+
+    /**
+     * Glyph requests that had to load the glyph
+     */
+    size_t misses;
+
+    /**
+     * Glyphs evicted from the atlas to make room for new ones
+     */
+    size_t evictions;
+
+} texture_font_stats_t;
+
+
 
 /**
  *  Texture font structure.
@@ -236,6 +344,33 @@ typedef struct texture_font_t
      */
     vector_t * glyphs;
 
+    /**
+     * Open addressing hash table indexing glyphs by codepoint, render mode
+     * and outline thickness. Its capacity is always a power of two.
+     */
+    texture_glyph_t ** glyph_index;
+
+    /**
+     * Number of slots in the glyph index.
+     */
+    size_t glyph_index_capacity;
+
+    /**
+     * Glyphs of codepoints below 256 in latin1_rendermode and
+     * latin1_thickness, NULL when not looked up yet.
+     */
+    texture_glyph_t * latin1_glyphs[256];
+
+    /**
+     * Render mode of the glyphs in latin1_glyphs.
+     */
+    rendermode_t latin1_rendermode;
+
+    /**
+     * Outline thickness of the glyphs in latin1_glyphs.
+     */
+    float latin1_thickness;
+
     /**
      * Atlas structure to store glyphs data.
      */
@@ -264,6 +399,38 @@ typedef struct texture_font_t
         } memory;
     };
 
+    /**
+     * FreeType library instance, kept for the whole life of the font
+     */
+    FT_Library library;
+
+    /**
+     * FreeType face, opened once and sized to the font size
+     */
+    FT_Face face;
+
+    /**
+     * Kerning pairs read from the font tables, NULL when the font has none
+     * that could be read (FT_Get_Kerning is used in that case).
+     */
+    kerning_table_t * kerning_table;
+
+    /**
+     * Loaded codepoints by glyph index, 1 + position in kerning_links of
+     * the last codepoint loaded with a given index (0 when there is none).
+     */
+    size_t * kerning_heads;
+
+    /**
+     * Links chaining the loaded codepoints sharing a same glyph index.
+     */
+    vector_t * kerning_links;
+
+    /**
+     * Kerning values between the loaded codepoints.
+     */
+    kerning_index_t kerning_index;
+
     /**
      * Font size
      */
@@ -299,6 +466,72 @@ typedef struct texture_font_t
      */
     int kerning;
 
+    /**
+     * Number of threads rasterizing glyphs in texture_font_load_glyphs,
+     * each one with a FreeType face of its own. Glyphs are rasterized by
+     * the calling thread only when 1 (default) or when the library is
+     * built without thread support. Packing in the atlas stays serial.
+     */
+    size_t threads;
+
+    /**
+     * Maximum number of atlas pages glyphs may be placed on. When 1 (default)
+     * glyphs that do not fit in the atlas fail to load, otherwise pages are
+     * added to the atlas as needed.
+     */
+    size_t max_pages;
+
+    /**
+     * Atlas size the texture coordinates of the glyphs were computed for,
+     * used to rescale them once the atlas has grown. Fonts growing the atlas
+     * rescale every font using it at once, a direct texture_atlas_resize is
+     * caught up with on the next glyph lookup.
+     */
+    size_t atlas_width, atlas_height;
+
+    /**
+     * Current frame, advanced by texture_font_next_frame. When the atlas is
+     * full, glyphs not requested during the current frame are evicted, least
+     * recently used first, to make room for new ones.
+     */
+    size_t frame;
+
+    /**
+     * Glyphs that may still be evicted during the current frame, least
+     * recently used last.
+     */
+    vector_t * evictable;
+
+    /**
+     * Glyph cache statistics.
+     */
+    texture_font_stats_t stats;
+
+    /**
+     * Transform computing the distance fields of glyphs rendered with
+     * RENDER_SIGNED_DISTANCE_FIELD, DISTANCE_FIELD_EDTAA3 by default.
+     * DISTANCE_FIELD_EXACT bounds the time taken per glyph, and
+     * DISTANCE_FIELD_OUTLINE measures distances to the glyph outline
+     * itself, without rasterizing it: exact at corners and thin stems, and
+     * cheapest with a distance_field_spread.
+     */
+    distance_field_method_t distance_field_method;
+
+    /**
+     * Distance in pixels from the edges of glyphs rendered with
+     * RENDER_SIGNED_DISTANCE_FIELD at which their fields reach 0 and 1, and
+     * padding added around them. Fields then have the same scale whatever the
+     * glyph or font, and distances beyond are not computed. When 0 (default)
+     * each glyph is normalized by its largest distance and padded by a pixel.
+     */
+    float distance_field_spread;
+
+    /**
+     * Buffers reused to compute the distance fields of the glyphs rendered
+     * by the calling thread, allocated with the first one.
+     */
+    distance_field_workspace_t * workspace;
+
 
     /**
      * This field is simply used to compute a default line spacing (i.e., the
@@ -396,7 +629,7 @@ typedef struct texture_font_t
 
 /**
  * Delete a texture font. Note that this does not delete the glyph from the
- * texture atlas.
+ * texture atlas. Fonts must be deleted before their atlas.
  *
  * @param self a valid texture font
  */
@@ -404,6 +637,48 @@ typedef struct texture_font_t
   texture_font_delete( texture_font_t * self );
 
 
+/**
+ * Start a new frame of the font. From then on, glyphs that have not been
+ * requested (with texture_font_get_glyph or texture_font_get_glyph_utf32)
+ * since the frame started may be evicted from the atlas when it runs out of
+ * space. Evicted glyphs are deleted and their atlas region is reused, so
+ * neither glyph pointers nor texture coordinates obtained in a previous frame
+ * may be used once this function is called unless the glyph is requested
+ * again. Fonts that never call this function never evict glyphs.
+ *
+ * @param self a valid texture font
+ */
+  void
+  texture_font_next_frame( texture_font_t * self );
+
+/**
+ * Repack the glyphs of every font placing glyphs in an atlas (those of its
+ * fonts vector) into a fresh layout, dropping the regions none of their
+ * glyphs uses anymore (those of deleted fonts for instance) and the
+ * fragmentation left by evictions. An atlas with no font left is cleared. Glyphs are copied,
+ * largest first, into a shadow atlas while the atlas itself is left
+ * untouched. Only then are both swapped and the texture coordinates and
+ * pages of the glyphs updated, after which the whole atlas needs to be
+ * uploaded again. Nothing changes if the new layout would need more pages
+ * than the current one.
+ *
+ * Texture coordinates copied elsewhere, such as in a text buffer, are not
+ * updated and the text must be added again.
+ *
+ * The repacking is synchronous: it runs entirely on the calling thread and
+ * takes time proportional to the number and area of the glyphs, followed by
+ * a full upload of the atlas. The shadow atlas only keeps the atlas valid
+ * while the copy is in progress; it does not hide that cost. Call it outside
+ * frame-critical paths, at a loading screen or after a level change, and
+ * not from a render loop.
+ *
+ * @param atlas the first page of the atlas shared by the fonts
+ * @return      area (in pixels) reclaimed from regions no glyph was using
+ */
+  size_t
+  texture_font_compact( texture_atlas_t * atlas );
+
+
 /**
  * Request a new glyph from the font. If it has not been created yet, it will
  * be.
@@ -419,6 +694,51 @@ typedef struct texture_font_t
   texture_font_get_glyph( texture_font_t * self,
                           const char * codepoint );
 
+/**
+ * Request a new glyph from the font given its UTF-32 codepoint. If it has not
+ * been created yet, it will be.
+ *
+ * @param self      A valid texture font
+ * @param codepoint Character codepoint in UTF-32, -1 for the special glyph
+ *                  used to draw lines and backgrounds.
+ *
+ * @return A pointer on the new glyph or 0 if the texture atlas is not big
+ *         enough
+ *
+ */
+  texture_glyph_t *
+  texture_font_get_glyph_utf32( texture_font_t * self,
+                                uint32_t codepoint );
+
+
+/**
+ * Look for a glyph already loaded in the font, in its current render mode
+ * and outline thickness.
+ *
+ * @param self      A valid texture font
+ * @param codepoint Character codepoint in UTF-8 encoding.
+ *
+ * @return A pointer on the glyph or 0 if it is not loaded
+ *
+ */
+  texture_glyph_t *
+  texture_font_find_glyph( texture_font_t * self,
+                           const char * codepoint );
+
+
+/**
+ * Look for a glyph already loaded in the font given its UTF-32 codepoint.
+ *
+ * @param self      A valid texture font
+ * @param codepoint Character codepoint in UTF-32.
+ *
+ * @return A pointer on the glyph or 0 if it is not loaded
+ *
+ */
+  texture_glyph_t *
+  texture_font_find_glyph_utf32( texture_font_t * self,
+                                 uint32_t codepoint );
+
 
 /**
  * Request the loading of a given glyph.
@@ -432,9 +752,25 @@ typedef struct texture_font_t
   texture_font_load_glyph( texture_font_t * self,
                            const char * codepoint );
 
+/**
+ * Request the loading of a given glyph given its UTF-32 codepoint.
+ *
+ * @param self       A valid texture font
+ * @param codepoint  Character codepoint to be loaded in UTF-32.
+ *
+ * @return One if the glyph could be loaded, zero if not.
+ */
+  int
+  texture_font_load_glyph_utf32( texture_font_t * self,
+                                 uint32_t codepoint );
+
 /**
  * Request the loading of several glyphs at once.
  *
+ * Glyphs are all rasterized first, then packed in the atlas from the
+ * tallest to the smallest one, and their kerning is computed last. This
+ * gives a better atlas occupancy than loading glyphs one by one.
+ *
  * @param self       A valid texture font
  * @param codepoints Character codepoints to be loaded in UTF-8 encoding. May
  *                   contain duplicates.
@@ -446,6 +782,52 @@ typedef struct texture_font_t
   texture_font_load_glyphs( texture_font_t * self,
                             const char * codepoints );
 
+/**
+ * Collect the printable characters mapped by the font face, in increasing
+ * codepoint order. C0 and C1 control characters are skipped.
+ *
+ * @param self       A valid texture font
+ * @param codepoints Array receiving the UTF-32 codepoints, may be NULL to
+ *                   only count them
+ * @param max        Maximum number of codepoints to collect
+ *
+ * @return Number of codepoints collected
+ */
+  size_t
+  texture_font_get_charcodes( texture_font_t * self,
+                              uint32_t * codepoints,
+                              size_t max );
+
+/**
+ * Decompose a FreeType outline into the lines and curves
+ * make_distance_map_outline measures distances to, as fonts do for
+ * DISTANCE_FIELD_OUTLINE.
+ *
+ * @param outline  outline in 26.6 fixed point, y pointing up
+ * @param left     abscissa, in pixels, of the left edge of the field
+ * @param top      ordinate, in pixels, of the top edge of the field
+ * @param segments vector of distance_field_segment_t the segments are
+ *                 appended to
+ */
+  void
+  texture_font_decompose_outline( const FT_Outline * outline,
+                                  float left, float top,
+                                  vector_t * segments );
+
+/**
+ * Get the kerning between two codepoints loaded in a font.
+ *
+ * @param self   A valid texture font
+ * @param left   Unicode codepoint of the preceding character in UTF-32
+ * @param right  Unicode codepoint of the following character in UTF-32
+ *
+ * @return x kerning value
+ */
+float
+texture_font_get_kerning( const texture_font_t * self,
+                          uint32_t left,
+                          uint32_t right );
+
 /**
  * Get the kerning between two horizontal glyphs.
  *
@@ -458,6 +840,19 @@ float
 texture_glyph_get_kerning( const texture_glyph_t * self,
                            const char * codepoint );
 
+/**
+ * Get the kerning between two horizontal glyphs given the UTF-32 codepoint of
+ * the preceding one.
+ *
+ * @param self      A valid texture glyph
+ * @param codepoint Character codepoint of the preceding character in UTF-32.
+ *
+ * @return x kerning value
+ */
+float
+texture_glyph_get_kerning_utf32( const texture_glyph_t * self,
+                                 uint32_t codepoint );
+
 
 /**
  * Creates a new empty glyph
@@ -111,3 +111,40 @@ utf8_to_utf32( const char * character )
 
     return result;
 }
+
+// ---------------------------------------------------------- utf32_to_utf8 ---
+size_t
+utf32_to_utf8( uint32_t codepoint, char * out )
+{
+    size_t length;
+
+    if( codepoint < 0x80 )
+    {
+        out[0] = codepoint;
+        length = 1;
+    }
+    else if( codepoint < 0x800 )
+    {
+        out[0] = 0xC0 | ( codepoint >> 6 );
+        out[1] = 0x80 | ( codepoint & 0x3F );
+        length = 2;
+    }
+    else if( codepoint < 0x10000 )
+    {
+        out[0] = 0xE0 | ( codepoint >> 12 );
+        out[1] = 0x80 | ( ( codepoint >> 6 ) & 0x3F );
+        out[2] = 0x80 | ( codepoint & 0x3F );
+        length = 3;
+    }
+    else
+    {
+        out[0] = 0xF0 | ( codepoint >> 18 );
+        out[1] = 0x80 | ( ( codepoint >> 12 ) & 0x3F );
+        out[2] = 0x80 | ( ( codepoint >> 6 ) & 0x3F );
+        out[3] = 0x80 | ( codepoint & 0x3F );
+        length = 4;
+    }
+    out[length] = 0;
+
+    return length;
+}
@@ -83,6 +83,18 @@ namespace ftgl {
   uint32_t
   utf8_to_utf32( const char * character );
 
+  /**
+   * Converts a given UTF-32 codepoint to its UTF-8 encoding
+   *
+   * @param codepoint  An UTF-32 codepoint
+   * @param out        Buffer of at least 5 bytes receiving the UTF-8
+   *                   encoded character followed by a null terminator
+   *
+   * @return  The length of the encoded character in bytes.
+   */
+  size_t
+  utf32_to_utf8( uint32_t codepoint, char * out );
+
 /**
  * @}
  */
@@ -163,6 +163,20 @@ vector_reserve( vector_t *self,
 }
 
 
+// ------------------------------------------------------------ vector_grow ---
+/* Reserves room for size items, at least doubling the capacity so that
+ * successive appends take amortized constant time. */
+static void
+vector_grow( vector_t *self,
+             const size_t size )
+{
+    if( self->capacity < size )
+    {
+        vector_reserve( self, size < 2 * self->capacity ? 2 * self->capacity : size );
+    }
+}
+
+
 // -------------------------------------------------------- vector_capacity ---
 size_t
 vector_capacity( const vector_t *self )
@@ -221,10 +235,7 @@ vector_insert( vector_t *self,
     assert( self );
     assert( index <= self->size);
 
-    if( self->capacity <= self->size )
-    {
-        vector_reserve(self, 2 * self->capacity );
-    }
+    vector_grow( self, self->size + 1 );
     if( index < self->size )
     {
         memmove( (char *)(self->items) + (index + 1) * self->item_size,
@@ -315,10 +326,7 @@ vector_push_back_data( vector_t *self,
     assert( data );
     assert( count );
 
-    if( self->capacity < (self->size+count) )
-    {
-        vector_reserve(self, self->size+count);
-    }
+    vector_grow( self, self->size + count );
     memmove( (char *)(self->items) + self->size * self->item_size, data,
              count*self->item_size );
     self->size += count;
@@ -337,13 +345,10 @@ vector_insert_data( vector_t *self,
     assert( data );
     assert( count );
 
-    if( self->capacity < (self->size+count) )
-    {
-        vector_reserve(self, self->size+count);
-    }
+    vector_grow( self, self->size + count );
     memmove( (char *)(self->items) + (index + count ) * self->item_size,
              (char *)(self->items) + (index ) * self->item_size,
-             count*self->item_size );
+             (self->size - index)*self->item_size );
     memmove( (char *)(self->items) + index * self->item_size, data,
              count*self->item_size );
     self->size += count;
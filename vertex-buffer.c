@@ -273,6 +273,21 @@ vertex_buffer_clear( vertex_buffer_t *self )
 }
 
 
+// ----------------------------------------------------------------------------
+void
+vertex_buffer_reserve( vertex_buffer_t *self,
+                       const size_t vcount,
+                       const size_t icount,
+                       const size_t count )
+{
+    assert( self );
+
+    vector_reserve( self->vertices, vector_size( self->vertices ) + vcount );
+    vector_reserve( self->indices, vector_size( self->indices ) + icount );
+    vector_reserve( self->items, vector_size( self->items ) + count );
+}
+
+
 
 // ----------------------------------------------------------------------------
 void
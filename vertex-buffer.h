@@ -210,6 +210,22 @@ typedef struct vertex_buffer_t
   vertex_buffer_clear( vertex_buffer_t *self );
 
 
+/**
+ * Reserve storage so that the given number of vertices, indices and items
+ * can be appended without any further reallocation.
+ *
+ * @param  self    a vertex buffer
+ * @param  vcount  number of vertices to make room for
+ * @param  icount  number of indices to make room for
+ * @param  count   number of items to make room for
+ */
+  void
+  vertex_buffer_reserve( vertex_buffer_t *self,
+                         const size_t vcount,
+                         const size_t icount,
+                         const size_t count );
+
+
 /**
  * Appends indices at the end of the buffer.
  *